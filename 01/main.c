@@ -2,6 +2,20 @@
 #include <conio.h>
 #include <string.h>
 #include <stdlib.h> // For system("cls") or system("clear")
+#include <stdint.h>
+#include <stdatomic.h> // For the sharded vote counters
+#include <time.h>
+#ifdef _WIN32
+#define _WIN32_WINNT 0x0600 // Condition variables need Windows Vista or later
+#include <windows.h> // For CreateThread(), Sleep(), CreateFileMapping()
+#include <io.h>      // For _commit()
+#else
+#include <pthread.h>
+#include <unistd.h>  // For sysconf(), usleep()
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 // --------------------------------------- Mulitplication Function ------------------------------
 // int main() {
 //     printf("Multiplication Program \n");
@@ -197,30 +211,256 @@
 
 
 
-#define MAX_CANDIDATES 10
+#define INITIAL_CANDIDATES 16   // The candidate table starts this big and doubles as needed
+#define MAX_LISTED_CANDIDATES 30 // Larger ballots are voted on by name or number without a listing
 #define MAX_NAME_LENGTH 50
+#define REGISTER_DUPLICATE -1   // registerCandidate(): name already taken
+#define REGISTER_NO_MEMORY -2   // registerCandidate(): table could not grow
+#define MAX_SHARDS 64        // Upper bound on concurrent ingestion threads
+#define CACHE_LINE_SIZE 64   // Shard rows are padded to this so producers never share a line
+#define BALLOT_BIN_MAGIC "VOTEBIN1"  // Binary ballot files start with this 8-byte tag
+#define BALLOT_BIN_HEADER 16         // Magic, then a little-endian uint32 record width, then padding
+#define MAX_RANKS 255                // Preferences kept per ranked ballot (cursor is one byte)
+#define JOURNAL_FILE "votes.journal"
+#define JOURNAL_MAGIC "VOTEJRN1"      // First 8 bytes of the journal file
+#define JOURNAL_BLOCK_TAG 0x4B4C4256u // "VBLK": starts every group-committed block
+#define JOURNAL_BLOCK_HEADER 12       // Tag, payload length and payload CRC-32, all uint32
+#define GROUP_COMMIT_WINDOW_MS 2      // How long the flusher lingers so concurrent votes share an fsync
+#define JOURNAL_COMPACT_BYTES (16 * 1024 * 1024) // Journals bigger than this are rewritten as a snapshot
 
 // Structure to represent a single candidate
 typedef struct {
     char name[MAX_NAME_LENGTH];
-    int votes;
+    unsigned int name_hash; // Cached so index probes and rehashing skip the string
+    long long votes;
+    int rank;               // Position in rank_order
+    int bucket;             // RankBucket holding every candidate with the same votes
 } Candidate;
 
-// Global array to store all candidates and a counter
-Candidate candidates[MAX_CANDIDATES];
+// A run of rank_order positions [start, end) whose candidates all have `votes`.
+// Runs are contiguous and ordered by descending votes, so a single vote only
+// ever moves a candidate from the front of its run into the run just above.
+typedef struct {
+    long long votes;
+    int start;
+    int end;
+} RankBucket;
+
+// Per-thread vote counters used by bulk ingestion. Every producer thread owns
+// one row of `counts`, so increments never contend on a shared cache line;
+// readers merge the rows on demand and endIngestion() folds them into
+// candidates[].votes once the producers are done.
+typedef struct {
+    atomic_llong *counts; // shard_count rows of `stride` counters, cache-line aligned
+    void *block;          // Raw allocation backing `counts`
+    int stride;           // Counters per row, rounded up to a whole cache line
+    int shard_count;
+    int active;           // Non-zero while producers may be writing
+    atomic_int finished;  // Producers that have returned
+} VoteShards;
+
+// Work handed to each ballot producer thread
+typedef struct {
+    int shard;
+    long long ballots;
+    uint64_t seed;
+} ProducerJob;
+
+// Slice of a ballot file handed to one parser thread
+typedef struct {
+    int shard;
+    const unsigned char *begin;
+    const unsigned char *end;
+    int record_width;     // 0 for text, otherwise bytes per binary record
+    long long accepted;
+    long long rejected;
+} BallotChunk;
+
+// A read-only view of a whole file mapped into memory
+typedef struct {
+    const unsigned char *data;
+    size_t size;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#else
+    int fd;
+#endif
+} MappedFile;
+
+// Ranked ballots in a compact columnar layout: every ballot's preferences are
+// stored back to back in `choices`, with `offsets` marking where each starts.
+// Counting state is kept in parallel per-ballot columns: `cursor` is how far
+// down its ranking the ballot currently counts, and `next` chains the ballots
+// sitting in the same candidate's pile.
+typedef struct {
+    unsigned int *choices;      // 0-based candidate indices
+    long long *offsets;         // Ballot b ranks choices[offsets[b] .. offsets[b + 1])
+    unsigned char *cursor;
+    int *next;
+    int ballot_count;
+    long long choice_count;
+    long long choice_capacity;
+    int ballot_capacity;
+} RankedBallots;
+
+#ifdef _WIN32
+typedef HANDLE ThreadHandle;
+typedef LPTHREAD_START_ROUTINE ThreadFunc;
+typedef CRITICAL_SECTION Mutex;
+typedef CONDITION_VARIABLE Condition;
+#define THREAD_RETURN DWORD WINAPI
+#define THREAD_RESULT 0
+#else
+typedef pthread_t ThreadHandle;
+typedef void *(*ThreadFunc)(void *);
+typedef pthread_mutex_t Mutex;
+typedef pthread_cond_t Condition;
+#define THREAD_RETURN void *
+#define THREAD_RESULT NULL
+#endif
+
+// Write-ahead journal of every candidate and vote. Appenders copy their
+// record into `pending` and get a sequence number; the flusher thread swaps
+// the buffers, writes everything pending as one checksummed block and fsyncs
+// once for the whole group, then wakes everyone whose record is now durable.
+//
+// File layout: JOURNAL_MAGIC, then blocks of {tag, payload length, CRC-32}
+// followed by the payload. Payload records are 'C' len name (new candidate),
+// 'V' index (one vote) and 'B' index count (bulk votes), little-endian.
+typedef struct {
+    FILE *file;                   // NULL when journaling is off
+    Mutex lock;
+    Condition work;               // Signalled when records are appended or on shutdown
+    Condition durable;            // Broadcast after each group is on disk
+    unsigned char *pending;
+    size_t pending_size;
+    size_t pending_capacity;
+    unsigned char *spare;         // The other buffer, owned by the flusher while it writes
+    size_t spare_capacity;
+    unsigned long long appended;  // Records appended so far
+    unsigned long long synced;    // Records known to be on disk
+    int stopping;
+    int failed;                   // A write or fsync failed; later records are not durable
+    ThreadHandle flusher;
+} VoteJournal;
+
+// Growable global array of candidates, its size and allocated capacity
+Candidate *candidates = NULL;
 int candidate_count = 0;
+int candidate_capacity = 0;
+
+// Open-addressing (linear probing) index from name to candidate slot.
+// Slots hold a candidate index or -1; the table is kept at most half full.
+int *name_index = NULL;
+int name_index_size = 0;
+
+// Candidates ordered by descending votes, plus the pool of runs over it.
+// Both are sized to candidate_capacity; spare_buckets is a stack of free ids.
+int *rank_order = NULL;
+RankBucket *rank_buckets = NULL;
+int *spare_buckets = NULL;
+int spare_bucket_count = 0;
+
+// Shard table for the ingestion currently in progress (if any)
+VoteShards vote_shards = {0};
+
+// Journal used by the interactive program (batch mode does not persist)
+VoteJournal vote_journal = {0};
+
+// Round tallies and standings of the runoff being counted, for compareRunoffOrder()
+const long long *runoff_tally = NULL;
+const int *runoff_standing = NULL;
 
 // Function Prototypes
 void addCandidate();
 void castVote();
 void displayResults();
 void findWinner();
+void showLeaderboard();
+void simulateBulkVoting();
+void importBallotFile();
 void clearInputBuffer();
 void displayMenu();
+int registerCandidate(const char *name);
+int findCandidate(const char *name, size_t length);
+unsigned int hashName(const char *name, size_t length);
+int growNameIndex();
+int growCandidateTable();
+void recordVote(int index);
+void rebuildRanking();
+int compareByRank(const void *a, const void *b);
+int checkRanking();
+int runSelfCheck();
+int compareIndex(const void *a, const void *b);
+int compareRunoffOrder(const void *a, const void *b);
+int takeBucket(long long votes, int start, int end);
+int loadCandidateFile(const char *path);
+int tallyBallotFile(const char *path, int thread_count);
+int runBatchMode(int argc, char *argv[]);
+THREAD_RETURN ballotFileWorker(void *arg);
+void rankedChoiceCount();
+int runInstantRunoff(const char *path);
+int loadRankedBallots(const char *path, RankedBallots *ballots, long long *rejected);
+int appendRankedChoice(RankedBallots *ballots, unsigned int choice);
+void freeRankedBallots(RankedBallots *ballots);
+int mapFile(const char *path, MappedFile *file);
+void unmapFile(MappedFile *file);
+int beginIngestion(int shard_count);
+void endIngestion();
+long long candidateVotes(int index);
+long long pendingShardVotes();
+void waitForProducers(ThreadHandle *threads, int thread_count, double start_time);
+int openJournal();
+void closeJournal();
+int replayJournal(const unsigned char *data, size_t size, size_t *valid_end, long long *records);
+int writeJournalSnapshot(const char *path);
+int writeJournalBlock(FILE *file, const unsigned char *payload, size_t length);
+unsigned long long journalAppend(const unsigned char *record, size_t length);
+unsigned long long journalCandidate(int index);
+unsigned long long journalVote(int index);
+unsigned long long journalBulkVotes(int index, long long count);
+int journalWaitDurable(unsigned long long sequence);
+THREAD_RETURN journalFlusher(void *arg);
+unsigned int crc32(const unsigned char *data, size_t length);
+void putU32(unsigned char *p, uint32_t value);
+uint32_t getU32(const unsigned char *p);
+int syncFile(FILE *file);
+int replaceFile(const char *from, const char *to);
+void initMutex(Mutex *mutex);
+void lockMutex(Mutex *mutex);
+void unlockMutex(Mutex *mutex);
+void initCondition(Condition *condition);
+void waitCondition(Condition *condition, Mutex *mutex);
+void signalCondition(Condition *condition);
+void broadcastCondition(Condition *condition);
+THREAD_RETURN ballotProducer(void *arg);
+int startThread(ThreadHandle *thread, ThreadFunc func, void *arg);
+void joinThread(ThreadHandle thread);
+int cpuCount();
+void sleepMillis(int ms);
+double nowSeconds();
+
+// Records one ballot in the calling producer's shard. Only the owning thread
+// writes a row, so a relaxed load/store pair is enough and compiles to a plain
+// increment; the atomics only make concurrent merge-on-read well defined.
+static inline void shardVote(int shard, int index) {
+    atomic_llong *counter = &vote_shards.counts[(size_t)shard * vote_shards.stride + index];
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + 1,
+                          memory_order_relaxed);
+}
 
-int main() {
+int main(int argc, char *argv[]) {
     int choice;
 
+    // Any command-line arguments select the non-interactive batch mode
+    if (argc > 1) {
+        return runBatchMode(argc, argv);
+    }
+
+    // Recover the election from the journal and keep recording to it
+    openJournal();
+
     // Main menu loop
     do {
         displayMenu();
@@ -249,15 +489,28 @@ int main() {
                 findWinner();
                 break;
             case 5:
+                simulateBulkVoting();
+                break;
+            case 6:
+                importBallotFile();
+                break;
+            case 7:
+                showLeaderboard();
+                break;
+            case 8:
+                rankedChoiceCount();
+                break;
+            case 9:
+                closeJournal();
                 printf("Exiting the voting system. Goodbye!\n");
                 break;
             default:
-                printf("Invalid choice! Please select a valid option (1-5).\n");
+                printf("Invalid choice! Please select a valid option (1-9).\n");
         }
         printf("\nPress Enter to continue...");
         getchar(); // Wait for user to press Enter
 
-    } while (choice != 5);
+    } while (choice != 9);
 
     return 0;
 }
@@ -271,28 +524,327 @@ void displayMenu() {
     printf("2. Cast Vote\n");
     printf("3. Show Vote Count\n");
     printf("4. Find Winner\n");
-    printf("5. Exit\n");
+    printf("5. Simulate Bulk Voting\n");
+    printf("6. Import Ballot File\n");
+    printf("7. Show Leaderboard\n");
+    printf("8. Ranked-Choice Count from File\n");
+    printf("9. Exit\n");
     printf("==================================\n");
     printf("Enter your choice: ");
 }
 
 // Adds a new candidate to the election
 void addCandidate() {
-    if (candidate_count >= MAX_CANDIDATES) {
-        printf("Maximum number of candidates reached (%d).\n", MAX_CANDIDATES);
-        return;
-    }
-
+    char name[MAX_NAME_LENGTH];
     printf("Enter the name of the new candidate: ");
     // fgets is safer than scanf for strings as it prevents buffer overflows
-    fgets(candidates[candidate_count].name, MAX_NAME_LENGTH, stdin);
+    fgets(name, MAX_NAME_LENGTH, stdin);
     // Remove the newline character that fgets stores
-    candidates[candidate_count].name[strcspn(candidates[candidate_count].name, "\n")] = 0;
+    name[strcspn(name, "\n")] = 0;
+
+    if (name[0] == 0) {
+        printf("Candidate name cannot be empty.\n");
+        return;
+    }
+    int index = registerCandidate(name);
+    switch (index) {
+        case REGISTER_DUPLICATE:
+            printf("A candidate named %s is already registered.\n", name);
+            break;
+        case REGISTER_NO_MEMORY:
+            printf("Error: Not enough memory to add another candidate.\n");
+            break;
+        default:
+            if (!journalWaitDurable(journalCandidate(index))) {
+                printf("Warning: The candidate could not be saved to %s.\n", JOURNAL_FILE);
+            }
+            printf("Candidate added successfully!\n");
+    }
+}
+
+// Appends a candidate with zero votes and indexes its name. Returns the new
+// index, REGISTER_DUPLICATE if the name is taken or REGISTER_NO_MEMORY.
+int registerCandidate(const char *name) {
+    size_t length = strlen(name);
+    if (length > MAX_NAME_LENGTH - 1) {
+        length = MAX_NAME_LENGTH - 1; // Same truncation the fgets() prompts apply
+    }
+    if (findCandidate(name, length) >= 0) {
+        return REGISTER_DUPLICATE;
+    }
+
+    if (candidate_count == candidate_capacity && !growCandidateTable()) {
+        return REGISTER_NO_MEMORY;
+    }
+    if ((candidate_count + 1) * 2 > name_index_size && !growNameIndex()) {
+        return REGISTER_NO_MEMORY;
+    }
+
+    Candidate *c = &candidates[candidate_count];
+    memcpy(c->name, name, length);
+    c->name[length] = 0;
+    c->name_hash = hashName(name, length);
+    c->votes = 0; // Initialize votes to zero
+
+    // New candidates join the bottom of the ranking, in the zero-vote run if there is one
+    int pos = candidate_count;
+    rank_order[pos] = pos;
+    c->rank = pos;
+    if (pos > 0 && rank_buckets[candidates[rank_order[pos - 1]].bucket].votes == 0) {
+        c->bucket = candidates[rank_order[pos - 1]].bucket;
+        rank_buckets[c->bucket].end++;
+    } else {
+        c->bucket = takeBucket(0, pos, pos + 1);
+    }
+
+    unsigned int mask = (unsigned int)name_index_size - 1;
+    unsigned int slot = c->name_hash & mask;
+    while (name_index[slot] >= 0) {
+        slot = (slot + 1) & mask;
+    }
+    name_index[slot] = candidate_count;
+    return candidate_count++;
+}
 
-    candidates[candidate_count].votes = 0; // Initialize votes to zero
-    candidate_count++;
+// Looks up a candidate by exact name (not NUL-terminated). Returns -1 if absent.
+// Safe to call from several threads as long as no candidate is being added.
+int findCandidate(const char *name, size_t length) {
+    if (name_index_size == 0 || length >= MAX_NAME_LENGTH) {
+        return -1;
+    }
+    unsigned int hash = hashName(name, length);
+    unsigned int mask = (unsigned int)name_index_size - 1;
+    for (unsigned int slot = hash & mask; name_index[slot] >= 0; slot = (slot + 1) & mask) {
+        const Candidate *c = &candidates[name_index[slot]];
+        if (c->name_hash == hash && memcmp(c->name, name, length) == 0 && c->name[length] == 0) {
+            return name_index[slot];
+        }
+    }
+    return -1;
+}
 
-    printf("Candidate added successfully!\n");
+// Grows the candidate array and the ranking arrays sized to it. Returns 0 on failure.
+int growCandidateTable() {
+    int new_capacity = candidate_capacity ? candidate_capacity * 2 : INITIAL_CANDIDATES;
+    Candidate *grown = realloc(candidates, (size_t)new_capacity * sizeof(Candidate));
+    if (grown == NULL) {
+        return 0;
+    }
+    candidates = grown;
+    int *order = realloc(rank_order, (size_t)new_capacity * sizeof(int));
+    if (order == NULL) {
+        return 0;
+    }
+    rank_order = order;
+    RankBucket *buckets = realloc(rank_buckets, (size_t)new_capacity * sizeof(RankBucket));
+    if (buckets == NULL) {
+        return 0;
+    }
+    rank_buckets = buckets;
+    int *spare = realloc(spare_buckets, (size_t)new_capacity * sizeof(int));
+    if (spare == NULL) {
+        return 0;
+    }
+    spare_buckets = spare;
+
+    // The new bucket ids are free; push them so the lowest ids come out first
+    for (int id = new_capacity - 1; id >= candidate_capacity; id--) {
+        spare_buckets[spare_bucket_count++] = id;
+    }
+    candidate_capacity = new_capacity;
+    return 1;
+}
+
+// Adds one vote and keeps the ranking sorted in O(1): swap the candidate to
+// the front of its run, then hand that position to the run one vote higher.
+void recordVote(int index) {
+    Candidate *c = &candidates[index];
+    RankBucket *run = &rank_buckets[c->bucket];
+    int front = run->start;
+    int other = rank_order[front];
+
+    rank_order[c->rank] = other;
+    candidates[other].rank = c->rank;
+    rank_order[front] = index;
+    c->rank = front;
+
+    int old_bucket = c->bucket;
+    run->start++;
+    c->votes++;
+    // Free the old run first: with the table full and every count distinct
+    // the pool is empty until it comes back
+    if (run->start == run->end) {
+        spare_buckets[spare_bucket_count++] = old_bucket;
+    }
+    if (front > 0 && rank_buckets[candidates[rank_order[front - 1]].bucket].votes == c->votes) {
+        c->bucket = candidates[rank_order[front - 1]].bucket;
+        rank_buckets[c->bucket].end++;
+    } else {
+        c->bucket = takeBucket(c->votes, front, front + 1);
+    }
+}
+
+// Pops a free bucket id and initialises it
+int takeBucket(long long votes, int start, int end) {
+    int id = spare_buckets[--spare_bucket_count];
+    rank_buckets[id].votes = votes;
+    rank_buckets[id].start = start;
+    rank_buckets[id].end = end;
+    return id;
+}
+
+// Re-sorts the ranking from scratch. Used after bulk ingestion, where many
+// candidates move by more than one vote at once.
+void rebuildRanking() {
+    for (int i = 0; i < candidate_count; i++) {
+        rank_order[i] = i;
+    }
+    qsort(rank_order, (size_t)candidate_count, sizeof(int), compareByRank);
+
+    spare_bucket_count = 0;
+    for (int id = candidate_capacity - 1; id >= 0; id--) {
+        spare_buckets[spare_bucket_count++] = id;
+    }
+    for (int pos = 0; pos < candidate_count; pos++) {
+        Candidate *c = &candidates[rank_order[pos]];
+        c->rank = pos;
+        if (pos > 0 && rank_buckets[candidates[rank_order[pos - 1]].bucket].votes == c->votes) {
+            c->bucket = candidates[rank_order[pos - 1]].bucket;
+            rank_buckets[c->bucket].end++;
+        } else {
+            c->bucket = takeBucket(c->votes, pos, pos + 1);
+        }
+    }
+}
+
+// Verifies that rank_order, the runs and the spare pool agree with the vote
+// counts. Returns 0 (after saying what is wrong) if they do not.
+int checkRanking() {
+    int used = 0;
+    for (int pos = 0; pos < candidate_count; pos++) {
+        const Candidate *c = &candidates[rank_order[pos]];
+        const RankBucket *run = &rank_buckets[c->bucket];
+        if (c->rank != pos || run->votes != c->votes || pos < run->start || pos >= run->end) {
+            printf("Ranking error: %s at position %d is not in its run.\n", c->name, pos);
+            return 0;
+        }
+        if (pos > 0 && candidates[rank_order[pos - 1]].votes < c->votes) {
+            printf("Ranking error: position %d has more votes than position %d.\n", pos, pos - 1);
+            return 0;
+        }
+        if (pos == run->start) {
+            used++;
+        }
+    }
+    if (used + spare_bucket_count != candidate_capacity) {
+        printf("Ranking error: %d runs in use and %d spare, but room for %d.\n", used, spare_bucket_count,
+               candidate_capacity);
+        return 0;
+    }
+    return 1;
+}
+
+// Exercises the incremental ranking on a fresh table, checking it after every
+// vote: first the case where the table is full and every candidate has a
+// different count, so the run pool is empty when the leader gets a vote, then
+// random votes while the table grows. Returns 0 if a check fails.
+int runSelfCheck() {
+    char name[MAX_NAME_LENGTH];
+    for (int i = 0; i < INITIAL_CANDIDATES; i++) {
+        snprintf(name, sizeof(name), "c%d", i);
+        if (registerCandidate(name) < 0) {
+            printf("Error: Could not register the self-check candidates.\n");
+            return 0;
+        }
+        for (int v = 0; v < i; v++) {
+            recordVote(i);
+        }
+    }
+    recordVote(INITIAL_CANDIDATES - 1);
+    if (!checkRanking()) {
+        return 0;
+    }
+
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+    for (int step = 0; step < 20000; step++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        if (step % 100 == 0) {
+            snprintf(name, sizeof(name), "grow%d", step);
+            if (registerCandidate(name) < 0) {
+                printf("Error: Could not register the self-check candidates.\n");
+                return 0;
+            }
+        } else {
+            recordVote((int)(state % (uint64_t)candidate_count));
+        }
+        if (!checkRanking()) {
+            return 0;
+        }
+    }
+    printf("Self-check passed: the ranking stayed consistent with %d candidates.\n", candidate_count);
+    return 1;
+}
+
+// qsort comparator: more votes first, then registration order
+int compareByRank(const void *a, const void *b) {
+    const Candidate *x = &candidates[*(const int *)a];
+    const Candidate *y = &candidates[*(const int *)b];
+    if (x->votes != y->votes) {
+        return x->votes > y->votes ? -1 : 1;
+    }
+    return *(const int *)a - *(const int *)b;
+}
+
+// qsort comparator for candidate indices (registration order)
+int compareIndex(const void *a, const void *b) {
+    return *(const int *)a - *(const int *)b;
+}
+
+// qsort comparator for the runoff: weakest first, by this round's tally, then
+// by standing after the earlier rounds, then earlier registration
+int compareRunoffOrder(const void *a, const void *b) {
+    int x = *(const int *)a, y = *(const int *)b;
+    if (runoff_tally[x] != runoff_tally[y]) {
+        return runoff_tally[x] < runoff_tally[y] ? -1 : 1;
+    }
+    if (runoff_standing[x] != runoff_standing[y]) {
+        return runoff_standing[x] < runoff_standing[y] ? -1 : 1;
+    }
+    return x - y;
+}
+
+// 32-bit FNV-1a hash of a candidate name
+unsigned int hashName(const char *name, size_t length) {
+    unsigned int hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// Doubles the name index and reinserts every candidate. Returns 0 on failure.
+int growNameIndex() {
+    int new_size = name_index_size ? name_index_size * 2 : INITIAL_CANDIDATES * 2;
+    int *grown = malloc((size_t)new_size * sizeof(int));
+    if (grown == NULL) {
+        return 0;
+    }
+    memset(grown, 0xff, (size_t)new_size * sizeof(int)); // Every slot starts empty (-1)
+
+    unsigned int mask = (unsigned int)new_size - 1;
+    for (int i = 0; i < candidate_count; i++) {
+        unsigned int slot = candidates[i].name_hash & mask;
+        while (grown[slot] >= 0) {
+            slot = (slot + 1) & mask;
+        }
+        grown[slot] = i;
+    }
+    free(name_index);
+    name_index = grown;
+    name_index_size = new_size;
+    return 1;
 }
 
 // Casts a vote for a chosen candidate
@@ -302,26 +854,41 @@ void castVote() {
         return;
     }
 
-    int choice;
+    char input[MAX_NAME_LENGTH + 2];
     printf("----- Cast Your Vote -----\n");
-    for (int i = 0; i < candidate_count; i++) {
-        printf("%d. %s\n", i + 1, candidates[i].name);
+    if (candidate_count <= MAX_LISTED_CANDIDATES) {
+        for (int i = 0; i < candidate_count; i++) {
+            printf("%d. %s\n", i + 1, candidates[i].name);
+        }
+    } else {
+        printf("%d candidates are registered.\n", candidate_count);
     }
     printf("--------------------------\n");
-    printf("Enter the number of the candidate you want to vote for: ");
+    printf("Enter the number or name of the candidate you want to vote for: ");
 
-    if (scanf("%d", &choice) != 1) {
-        printf("Invalid input. Please enter a number.\n");
-        clearInputBuffer();
+    if (fgets(input, sizeof(input), stdin) == NULL) {
         return;
     }
-    clearInputBuffer();
+    if (strchr(input, '\n') == NULL) {
+        clearInputBuffer(); // Name was longer than any registered one; drop the rest
+    }
+    input[strcspn(input, "\n")] = 0;
+
+    // A plain number picks by position, anything else is looked up by name
+    char *end;
+    long number = strtol(input, &end, 10);
+    int choice = (end != input && *end == 0) ? (number > 0 && number <= candidate_count ? (int)number - 1 : -1)
+                                             : findCandidate(input, strlen(input));
 
-    if (choice > 0 && choice <= candidate_count) {
-        candidates[choice - 1].votes++;
-        printf("Your vote for %s has been cast!\n", candidates[choice - 1].name);
+    if (choice >= 0) {
+        recordVote(choice);
+        // Only confirm the vote once its group has been fsynced
+        if (!journalWaitDurable(journalVote(choice))) {
+            printf("Warning: This vote could not be saved to %s.\n", JOURNAL_FILE);
+        }
+        printf("Your vote for %s has been cast!\n", candidates[choice].name);
     } else {
-        printf("Invalid candidate number. Please try again.\n");
+        printf("Invalid candidate number or name. Please try again.\n");
     }
 }
 
@@ -334,7 +901,7 @@ void displayResults() {
 
     printf("----- ELECTION RESULTS -----\n");
     for (int i = 0; i < candidate_count; i++) {
-        printf("%s: %d votes\n", candidates[i].name, candidates[i].votes);
+        printf("%s: %lld votes\n", candidates[i].name, candidateVotes(i));
     }
     printf("----------------------------\n");
 }
@@ -346,28 +913,1366 @@ void findWinner() {
         return;
     }
 
-    int max_votes = -1;
+    // The leaders are exactly the first run of the ranking
+    const RankBucket *top = &rank_buckets[candidates[rank_order[0]].bucket];
+    long long max_votes = top->votes;
 
-    // First, find the highest vote count
-    for (int i = 0; i < candidate_count; i++) {
-        if (candidates[i].votes > max_votes) {
-            max_votes = candidates[i].votes;
-        }
-    }
-    
     if (max_votes == 0) {
         printf("No votes have been cast yet. Cannot determine a winner.\n");
         return;
     }
 
+    // Report ties in registration order, like the full results table
+    int tied = top->end - top->start;
+    int *winners = malloc((size_t)tied * sizeof(int));
+    if (winners == NULL) {
+        printf("Error: Not enough memory to list the winners.\n");
+        return;
+    }
+    memcpy(winners, rank_order, (size_t)tied * sizeof(int));
+    qsort(winners, (size_t)tied, sizeof(int), compareIndex);
+
     printf("----- WINNER(S) -----\n");
-    // Second, find all candidates who have that highest vote count (to handle ties)
+    for (int i = 0; i < tied; i++) {
+        printf("Winner: %s with %lld votes!\n", candidates[winners[i]].name, max_votes);
+    }
+    printf("----------------------\n");
+    free(winners);
+}
+
+// Displays the top k candidates by votes, extended to include anyone tied with the last place
+void showLeaderboard() {
+    if (candidate_count == 0) {
+        printf("No candidates are registered.\n");
+        return;
+    }
+
+    int k;
+    printf("How many places should the leaderboard show? ");
+    if (scanf("%d", &k) != 1 || k < 1) {
+        printf("Invalid number of places.\n");
+        clearInputBuffer();
+        return;
+    }
+    clearInputBuffer();
+    if (k > candidate_count) {
+        k = candidate_count;
+    }
+
+    // Everything up to the end of the run holding place k; only those rows are touched
+    int shown = rank_buckets[candidates[rank_order[k - 1]].bucket].end;
+    int *rows = malloc((size_t)shown * sizeof(int));
+    if (rows == NULL) {
+        printf("Error: Not enough memory for the leaderboard.\n");
+        return;
+    }
+    memcpy(rows, rank_order, (size_t)shown * sizeof(int));
+    qsort(rows, (size_t)shown, sizeof(int), compareByRank);
+
+    printf("----- LEADERBOARD -----\n");
+    for (int i = 0; i < shown; i++) {
+        // Tied candidates share a place number
+        int place = rank_buckets[candidates[rows[i]].bucket].start + 1;
+        printf("%3d. %s: %lld votes\n", place, candidates[rows[i]].name, candidates[rows[i]].votes);
+    }
+    printf("-----------------------\n");
+    free(rows);
+}
+
+// Generates random ballots on many threads to load-test the ingestion engine
+void simulateBulkVoting() {
+    if (candidate_count == 0) {
+        printf("No candidates have been registered yet. Please add a candidate first.\n");
+        return;
+    }
+
+    long long ballots;
+    int thread_count;
+    printf("----- Simulate Bulk Voting -----\n");
+    printf("Enter the number of ballots to generate: ");
+    if (scanf("%lld", &ballots) != 1 || ballots <= 0) {
+        printf("Invalid number of ballots.\n");
+        clearInputBuffer();
+        return;
+    }
+    clearInputBuffer();
+    printf("Enter the number of producer threads (0 = one per core): ");
+    if (scanf("%d", &thread_count) != 1 || thread_count < 0) {
+        printf("Invalid number of threads.\n");
+        clearInputBuffer();
+        return;
+    }
+    clearInputBuffer();
+    if (thread_count == 0) {
+        thread_count = cpuCount();
+    }
+    if (thread_count > MAX_SHARDS) {
+        thread_count = MAX_SHARDS;
+    }
+
+    if (!beginIngestion(thread_count)) {
+        printf("Error: Not enough memory for %d vote shards.\n", thread_count);
+        return;
+    }
+
+    ProducerJob jobs[MAX_SHARDS];
+    ThreadHandle threads[MAX_SHARDS];
+    uint64_t seed = (uint64_t)time(NULL);
+    double start = nowSeconds();
+    int started = 0;
+
+    for (int i = 0; i < thread_count; i++) {
+        jobs[i].shard = i;
+        // Spread the remainder over the first few producers
+        jobs[i].ballots = ballots / thread_count + (i < ballots % thread_count ? 1 : 0);
+        jobs[i].seed = (seed + (uint64_t)(i + 1) * 0x9E3779B97F4A7C15ULL) | 1;
+    }
+    for (; started < thread_count; started++) {
+        if (!startThread(&threads[started], ballotProducer, &jobs[started])) {
+            printf("Warning: could only start %d producer threads.\n", started);
+            break;
+        }
+    }
+    // Any job that could not get its own thread runs on this one
+    for (int i = started; i < thread_count; i++) {
+        ballotProducer(&jobs[i]);
+    }
+
+    waitForProducers(threads, started, start);
+    double elapsed = nowSeconds() - start;
+    endIngestion();
+
+    printf("Ingested %lld ballots on %d threads in %.3f seconds", ballots, thread_count, elapsed);
+    if (elapsed > 0) {
+        printf(" (%.0f ballots/second)", ballots / elapsed);
+    }
+    printf(".\n");
+}
+
+// Producer thread body: draws uniformly random candidates into its own shard
+THREAD_RETURN ballotProducer(void *arg) {
+    ProducerJob *job = (ProducerJob *)arg;
+    uint64_t state = job->seed;
+    uint32_t n = (uint32_t)candidate_count;
+
+    for (long long i = 0; i < job->ballots; i++) {
+        // xorshift64 with a multiply-shift range reduction (no division per ballot)
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        shardVote(job->shard, (int)(((state >> 32) * n) >> 32));
+    }
+    atomic_fetch_add(&vote_shards.finished, 1);
+    return THREAD_RESULT;
+}
+
+// Prompts for a ballot file and tallies it into the current election
+void importBallotFile() {
+    if (candidate_count == 0) {
+        printf("No candidates have been registered yet. Please add a candidate first.\n");
+        return;
+    }
+
+    char path[260];
+    printf("----- Import Ballot File -----\n");
+    printf("Text files hold one candidate number or name per line; binary files start with %s.\n",
+           BALLOT_BIN_MAGIC);
+    printf("Enter the path of the ballot file: ");
+    fgets(path, sizeof(path), stdin);
+    path[strcspn(path, "\n")] = 0;
+
+    tallyBallotFile(path, cpuCount());
+}
+
+// Counts every ballot in `path` on up to `thread_count` threads.
+// Returns 1 on success, 0 if the file could not be read.
+int tallyBallotFile(const char *path, int thread_count) {
+    MappedFile file;
+    if (!mapFile(path, &file)) {
+        printf("Error: Could not open ballot file %s.\n", path);
+        return 0;
+    }
+
+    const unsigned char *begin = file.data;
+    const unsigned char *end = file.data + file.size;
+    int record_width = 0;
+
+    if (file.size >= BALLOT_BIN_HEADER && memcmp(file.data, BALLOT_BIN_MAGIC, 8) == 0) {
+        record_width = file.data[8] | file.data[9] << 8 | file.data[10] << 16 | file.data[11] << 24;
+        if (record_width != 1 && record_width != 2 && record_width != 4) {
+            printf("Error: Unsupported record width %d in %s.\n", record_width, path);
+            unmapFile(&file);
+            return 0;
+        }
+        begin += BALLOT_BIN_HEADER;
+        end = begin + (size_t)(end - begin) / record_width * record_width;
+    }
+
+    if (thread_count > MAX_SHARDS) {
+        thread_count = MAX_SHARDS;
+    }
+    // Small files are not worth waking up extra threads for
+    if ((size_t)(end - begin) < (size_t)thread_count * 65536) {
+        thread_count = (int)((end - begin) / 65536) + 1;
+    }
+    if (!beginIngestion(thread_count)) {
+        printf("Error: Not enough memory for %d vote shards.\n", thread_count);
+        unmapFile(&file);
+        return 0;
+    }
+
+    // Split into contiguous chunks: text chunks end on a line break, binary ones on a record
+    BallotChunk chunks[MAX_SHARDS];
+    size_t span = (size_t)(end - begin);
+    const unsigned char *cursor = begin;
+    for (int i = 0; i < thread_count; i++) {
+        const unsigned char *stop = end;
+        if (i < thread_count - 1) {
+            if (record_width > 0) {
+                stop = begin + span / record_width * (i + 1) / thread_count * record_width;
+            } else {
+                stop = begin + span / thread_count * (i + 1);
+                const unsigned char *nl = memchr(stop, '\n', (size_t)(end - stop));
+                stop = nl ? nl + 1 : end;
+            }
+            if (stop < cursor) {
+                stop = cursor;
+            }
+        }
+        chunks[i].shard = i;
+        chunks[i].begin = cursor;
+        chunks[i].end = stop;
+        chunks[i].record_width = record_width;
+        chunks[i].accepted = 0;
+        chunks[i].rejected = 0;
+        cursor = stop;
+    }
+
+    ThreadHandle threads[MAX_SHARDS];
+    double start = nowSeconds();
+    int started = 0;
+    for (; started < thread_count; started++) {
+        if (!startThread(&threads[started], ballotFileWorker, &chunks[started])) {
+            break;
+        }
+    }
+    for (int i = started; i < thread_count; i++) {
+        ballotFileWorker(&chunks[i]);
+    }
+    waitForProducers(threads, started, start);
+    double elapsed = nowSeconds() - start;
+    endIngestion();
+
+    long long accepted = 0, rejected = 0;
+    for (int i = 0; i < thread_count; i++) {
+        accepted += chunks[i].accepted;
+        rejected += chunks[i].rejected;
+    }
+    printf("Counted %lld ballots from %s in %.3f seconds", accepted, path, elapsed);
+    if (elapsed > 0) {
+        printf(" (%.1f MB/s)", file.size / elapsed / (1024.0 * 1024.0));
+    }
+    printf(".\n");
+    if (rejected > 0) {
+        printf("Rejected %lld ballots that did not name a registered candidate.\n", rejected);
+    }
+
+    unmapFile(&file);
+    return 1;
+}
+
+// Parser thread body: decodes one chunk of a ballot file into its own shard.
+// Text records are a 1-based candidate number or an exact candidate name per
+// line; blank lines and lines starting with '#' are ignored.
+THREAD_RETURN ballotFileWorker(void *arg) {
+    BallotChunk *chunk = (BallotChunk *)arg;
+    const unsigned char *p = chunk->begin;
+    const unsigned char *end = chunk->end;
+    unsigned int limit = (unsigned int)candidate_count;
+    long long accepted = 0, rejected = 0;
+
+    if (chunk->record_width > 0) {
+        // Fixed-width little-endian candidate numbers, 1-based like the menu
+        int width = chunk->record_width;
+        for (; p < end; p += width) {
+            unsigned int number = p[0];
+            if (width >= 2) number |= (unsigned int)p[1] << 8;
+            if (width == 4) number |= (unsigned int)p[2] << 16 | (unsigned int)p[3] << 24;
+            if (number - 1 < limit) {
+                shardVote(chunk->shard, (int)(number - 1));
+                accepted++;
+            } else {
+                rejected++;
+            }
+        }
+    } else {
+        while (p < end) {
+            const unsigned char *line = p;
+            const unsigned char *nl = memchr(p, '\n', (size_t)(end - p));
+            const unsigned char *line_end = nl ? nl : end;
+            p = nl ? nl + 1 : end;
+
+            while (line < line_end && (*line == ' ' || *line == '\t')) line++;
+            while (line_end > line && (line_end[-1] == '\r' || line_end[-1] == ' ' || line_end[-1] == '\t')) line_end--;
+            if (line == line_end || *line == '#') {
+                continue;
+            }
+
+            // All digits means a candidate number; anything else is a name
+            unsigned int number = 0;
+            const unsigned char *q = line;
+            while (q < line_end && (unsigned char)(*q - '0') < 10) {
+                number = number > limit ? number : number * 10 + (*q - '0');
+                q++;
+            }
+            int index = (q == line_end) ? (number - 1 < limit ? (int)number - 1 : -1)
+                                        : findCandidate((const char *)line, (size_t)(line_end - line));
+            if (index >= 0) {
+                shardVote(chunk->shard, index);
+                accepted++;
+            } else {
+                rejected++;
+            }
+        }
+    }
+
+    chunk->accepted = accepted;
+    chunk->rejected = rejected;
+    atomic_fetch_add(&vote_shards.finished, 1);
+    return THREAD_RESULT;
+}
+
+// Registers one candidate per non-blank line of `path`. Returns 0 on failure.
+int loadCandidateFile(const char *path) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        printf("Error: Could not open candidate file %s.\n", path);
+        return 0;
+    }
+    char name[256];
+    while (fgets(name, sizeof(name), file) != NULL) {
+        name[strcspn(name, "\r\n")] = 0;
+        if (name[0] == 0) {
+            continue;
+        }
+        int result = registerCandidate(name);
+        if (result == REGISTER_DUPLICATE) {
+            printf("Warning: Skipping duplicate candidate %s.\n", name);
+        } else if (result == REGISTER_NO_MEMORY) {
+            printf("Error: Not enough memory for the candidates in %s.\n", path);
+            fclose(file);
+            return 0;
+        }
+    }
+    fclose(file);
+    return 1;
+}
+
+// Non-interactive mode, e.g. `main --candidates names.txt --tally ballots.log`.
+// Every --tally file is counted in order, then the results and winner are
+// printed. --irv runs an instant-runoff count of a ranked ballot file instead.
+// --self-check on its own tests the incremental ranking and exits.
+int runBatchMode(int argc, char *argv[]) {
+    int thread_count = cpuCount();
+    int tallied = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            thread_count = atoi(argv[++i]);
+            if (thread_count < 1) {
+                thread_count = 1;
+            }
+        } else if (strcmp(argv[i], "--candidates") == 0 && i + 1 < argc) {
+            if (!loadCandidateFile(argv[++i])) {
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--tally") == 0 && i + 1 < argc) {
+            if (candidate_count == 0) {
+                printf("Error: Register candidates with --candidates before --tally.\n");
+                return 1;
+            }
+            if (!tallyBallotFile(argv[++i], thread_count)) {
+                return 1;
+            }
+            tallied = 1;
+        } else if (strcmp(argv[i], "--self-check") == 0 && argc == 2) {
+            return runSelfCheck() ? 0 : 1;
+        } else if (strcmp(argv[i], "--irv") == 0 && i + 1 < argc) {
+            if (candidate_count == 0) {
+                printf("Error: Register candidates with --candidates before --irv.\n");
+                return 1;
+            }
+            if (!runInstantRunoff(argv[++i])) {
+                return 1;
+            }
+        } else {
+            printf("Usage: %s [--threads N] --candidates FILE (--tally BALLOTS | --irv RANKED_BALLOTS)...\n", argv[0]);
+            printf("       %s --self-check\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (tallied) {
+        displayResults();
+        findWinner();
+    }
+    return 0;
+}
+
+// Prompts for a ranked ballot file and runs an instant-runoff count on it
+void rankedChoiceCount() {
+    if (candidate_count == 0) {
+        printf("No candidates have been registered yet. Please add a candidate first.\n");
+        return;
+    }
+
+    char path[260];
+    printf("----- Ranked-Choice Count -----\n");
+    printf("Each line is one ballot listing candidate numbers or names in order of preference,\n");
+    printf("separated by commas (e.g. 2,1,3).\n");
+    printf("Enter the path of the ranked ballot file: ");
+    fgets(path, sizeof(path), stdin);
+    path[strcspn(path, "\n")] = 0;
+
+    runInstantRunoff(path);
+}
+
+// Instant-runoff count over a ranked ballot file. Each round the candidate
+// with the fewest continuing votes is eliminated and only the ballots in its
+// pile are moved on to their next surviving preference, so a round costs
+// time proportional to the ballots it transfers, not the whole file. A tie
+// for last goes against whoever stood lower after the earlier rounds, then
+// against the earlier-registered candidate. Several candidates go at once only
+// when their combined votes are below the next-lowest tally, as none of them
+// could then overtake it. This count does not touch the first-past-the-post
+// totals. Returns 0 if the file is unusable.
+int runInstantRunoff(const char *path) {
+    RankedBallots ballots;
+    long long rejected = 0;
+    double start = nowSeconds();
+    if (!loadRankedBallots(path, &ballots, &rejected)) {
+        return 0;
+    }
+    double loaded = nowSeconds();
+
+    int n = candidate_count;
+    int words = (n + 63) / 64;
+    long long *tally = calloc((size_t)n, sizeof(long long));
+    int *pile = malloc((size_t)n * sizeof(int));
+    uint64_t *eliminated = calloc((size_t)words, sizeof(uint64_t));
+    int *order = malloc((size_t)n * sizeof(int));
+    int *standing = calloc((size_t)n, sizeof(int));
+    if (tally == NULL || pile == NULL || eliminated == NULL || order == NULL || standing == NULL) {
+        printf("Error: Not enough memory for the runoff count.\n");
+        free(tally); free(pile); free(eliminated); free(order); free(standing);
+        freeRankedBallots(&ballots);
+        return 0;
+    }
+    for (int c = 0; c < n; c++) {
+        pile[c] = -1;
+    }
+
+    // First preferences
+    long long exhausted = 0;
+    for (int b = 0; b < ballots.ballot_count; b++) {
+        if (ballots.offsets[b] == ballots.offsets[b + 1]) {
+            exhausted++; // Nothing valid was ranked
+            continue;
+        }
+        unsigned int top = ballots.choices[ballots.offsets[b]];
+        ballots.cursor[b] = 0;
+        ballots.next[b] = pile[top];
+        pile[top] = b;
+        tally[top]++;
+    }
+
+    printf("Loaded %d ranked ballots from %s in %.3f seconds.\n", ballots.ballot_count, path, loaded - start);
+    if (rejected > 0) {
+        printf("Ignored %lld preferences that did not name a registered candidate.\n", rejected);
+    }
+
+    int remaining = n;
+    for (int round = 1; ; round++) {
+        long long continuing = 0, most = -1, fewest = -1;
+        int leader = -1;
+        for (int c = 0; c < n; c++) {
+            if (eliminated[c / 64] >> (c % 64) & 1) {
+                continue;
+            }
+            continuing += tally[c];
+            if (tally[c] > most) {
+                most = tally[c];
+                leader = c;
+            }
+            if (fewest < 0 || tally[c] < fewest) {
+                fewest = tally[c];
+            }
+        }
+
+        printf("----- ROUND %d -----\n", round);
+        if (remaining <= MAX_LISTED_CANDIDATES) {
+            for (int c = 0; c < n; c++) {
+                if (!(eliminated[c / 64] >> (c % 64) & 1)) {
+                    printf("%s: %lld votes\n", candidates[c].name, tally[c]);
+                }
+            }
+        } else {
+            printf("%d candidates remain; %s leads with %lld votes.\n", remaining, candidates[leader].name, most);
+        }
+        printf("Exhausted ballots: %lld\n", exhausted);
+
+        if (continuing == 0) {
+            printf("No ballots remain. Cannot determine a winner.\n");
+            break;
+        }
+        if (most * 2 > continuing || remaining == 1) {
+            printf("Winner: %s with %lld of %lld continuing votes!\n", candidates[leader].name, most, continuing);
+            break;
+        }
+
+        // Weakest first; then fold this round into the standings, with
+        // candidates tied now and in every earlier round sharing a standing
+        int ordered = 0;
+        for (int c = 0; c < n; c++) {
+            if (!(eliminated[c / 64] >> (c % 64) & 1)) {
+                order[ordered++] = c;
+            }
+        }
+        runoff_tally = tally;
+        runoff_standing = standing;
+        qsort(order, (size_t)ordered, sizeof(int), compareRunoffOrder);
+        int level = 0;
+        for (int i = 1, previous = standing[order[0]]; i <= ordered; i++) {
+            int c = order[i - 1];
+            if (i > 1 && (tally[c] != tally[order[i - 2]] || standing[c] != previous)) {
+                level++;
+            }
+            previous = standing[c];
+            standing[c] = level;
+        }
+        if (level == 0) {
+            printf("The remaining candidates are tied with %lld votes each:\n", fewest);
+            for (int i = 0; i < ordered; i++) {
+                printf("Winner: %s with %lld votes!\n", candidates[order[i]].name, fewest);
+            }
+            break;
+        }
+
+        // The weakest candidate goes, and with it every candidate below the
+        // longest prefix whose combined votes trail the next-lowest tally
+        int loser_count = 1;
+        long long combined = 0;
+        for (int k = 1; k < ordered; k++) {
+            combined += tally[order[k - 1]];
+            if (combined < tally[order[k]]) {
+                loser_count = k;
+            }
+        }
+        int *losers = order;
+        long long lost_votes = 0;
+        for (int i = 0; i < loser_count; i++) {
+            lost_votes += tally[losers[i]];
+        }
+
+        // Mark every loser first so transfers skip all of them at once
+        for (int i = 0; i < loser_count; i++) {
+            eliminated[losers[i] / 64] |= (uint64_t)1 << (losers[i] % 64);
+        }
+        remaining -= loser_count;
+        if (loser_count <= MAX_LISTED_CANDIDATES) {
+            for (int i = 0; i < loser_count; i++) {
+                printf("Eliminated: %s\n", candidates[losers[i]].name);
+            }
+        } else {
+            printf("Eliminated %d candidates with %lld votes between them.\n", loser_count, lost_votes);
+        }
+
+        // Transfer only the ballots currently counting for an eliminated candidate
+        for (int i = 0; i < loser_count; i++) {
+            int b = pile[losers[i]];
+            while (b >= 0) {
+                int following = ballots.next[b];
+                long long first = ballots.offsets[b];
+                int ranks = (int)(ballots.offsets[b + 1] - first);
+                int at = ballots.cursor[b] + 1;
+                while (at < ranks && (eliminated[ballots.choices[first + at] / 64] >> (ballots.choices[first + at] % 64) & 1)) {
+                    at++;
+                }
+                if (at < ranks) {
+                    unsigned int to = ballots.choices[first + at];
+                    ballots.cursor[b] = (unsigned char)at;
+                    ballots.next[b] = pile[to];
+                    pile[to] = b;
+                    tally[to]++;
+                } else {
+                    exhausted++;
+                }
+                b = following;
+            }
+            pile[losers[i]] = -1;
+            tally[losers[i]] = 0;
+        }
+    }
+    printf("--------------------\n");
+    printf("Runoff counted in %.3f seconds.\n", nowSeconds() - loaded);
+
+    free(tally);
+    free(pile);
+    free(eliminated);
+    free(order);
+    free(standing);
+    freeRankedBallots(&ballots);
+    return 1;
+}
+
+// Parses a ranked ballot file into the columnar layout. Unknown or repeated
+// preferences are dropped (and counted in *rejected); a ballot keeps at most
+// MAX_RANKS preferences. Returns 0 on failure.
+int loadRankedBallots(const char *path, RankedBallots *ballots, long long *rejected) {
+    memset(ballots, 0, sizeof(*ballots));
+
+    MappedFile file;
+    if (!mapFile(path, &file)) {
+        printf("Error: Could not open ballot file %s.\n", path);
+        return 0;
+    }
+    // Ballot number that last ranked each candidate, to spot repeats in O(1)
+    int *seen = malloc((size_t)candidate_count * sizeof(int));
+    if (seen == NULL) {
+        unmapFile(&file);
+        printf("Error: Not enough memory to read %s.\n", path);
+        return 0;
+    }
+    memset(seen, 0xff, (size_t)candidate_count * sizeof(int));
+
+    const unsigned char *p = file.data;
+    const unsigned char *end = file.data + file.size;
+    unsigned int limit = (unsigned int)candidate_count;
+    int ok = 1;
+
+    while (p < end && ok) {
+        const unsigned char *nl = memchr(p, '\n', (size_t)(end - p));
+        const unsigned char *line_end = nl ? nl : end;
+        const unsigned char *line = p;
+        p = nl ? nl + 1 : end;
+
+        while (line < line_end && (*line == ' ' || *line == '\t')) line++;
+        if (line == line_end || *line == '#' || (*line == '\r' && line + 1 == line_end)) {
+            continue;
+        }
+        if (ballots->ballot_count == ballots->ballot_capacity) {
+            if (ballots->ballot_capacity > 0x3fffffff) {
+                ok = 0; // Ballot numbers must fit the int-sized pile links
+                break;
+            }
+            int grown = ballots->ballot_capacity ? ballots->ballot_capacity * 2 : 1024;
+            long long *offsets = realloc(ballots->offsets, ((size_t)grown + 1) * sizeof(long long));
+            if (offsets == NULL) {
+                ok = 0;
+                break;
+            }
+            ballots->offsets = offsets;
+            ballots->ballot_capacity = grown;
+        }
+        int b = ballots->ballot_count;
+        ballots->offsets[b] = ballots->choice_count;
+        int ranks = 0;
+
+        // Split on commas; each field is a candidate number or name
+        while (line < line_end) {
+            const unsigned char *comma = memchr(line, ',', (size_t)(line_end - line));
+            const unsigned char *field_end = comma ? comma : line_end;
+            const unsigned char *field = line;
+            line = comma ? comma + 1 : line_end;
+
+            while (field < field_end && (*field == ' ' || *field == '\t')) field++;
+            while (field_end > field && (field_end[-1] == '\r' || field_end[-1] == ' ' || field_end[-1] == '\t')) field_end--;
+            if (field == field_end) {
+                continue;
+            }
+            unsigned int number = 0;
+            const unsigned char *q = field;
+            while (q < field_end && (unsigned char)(*q - '0') < 10) {
+                number = number > limit ? number : number * 10 + (*q - '0');
+                q++;
+            }
+            int index = (q == field_end) ? (number - 1 < limit ? (int)number - 1 : -1)
+                                         : findCandidate((const char *)field, (size_t)(field_end - field));
+            if (index < 0 || seen[index] == b || ranks == MAX_RANKS) {
+                (*rejected)++;
+                continue;
+            }
+            seen[index] = b;
+            if (!appendRankedChoice(ballots, (unsigned int)index)) {
+                ok = 0;
+                break;
+            }
+            ranks++;
+        }
+        ballots->ballot_count++;
+    }
+    if (ok) {
+        ballots->offsets = ballots->offsets ? ballots->offsets : malloc(sizeof(long long));
+        ballots->cursor = malloc((size_t)ballots->ballot_count + 1);
+        ballots->next = malloc(((size_t)ballots->ballot_count + 1) * sizeof(int));
+        ok = ballots->offsets != NULL && ballots->cursor != NULL && ballots->next != NULL;
+    }
+    if (ok) {
+        ballots->offsets[ballots->ballot_count] = ballots->choice_count;
+    } else {
+        printf("Error: Not enough memory to read %s.\n", path);
+        freeRankedBallots(ballots);
+    }
+
+    free(seen);
+    unmapFile(&file);
+    return ok;
+}
+
+// Appends one preference to the ballot being parsed. Returns 0 on failure.
+int appendRankedChoice(RankedBallots *ballots, unsigned int choice) {
+    if (ballots->choice_count == ballots->choice_capacity) {
+        long long grown = ballots->choice_capacity ? ballots->choice_capacity * 2 : 4096;
+        unsigned int *choices = realloc(ballots->choices, (size_t)grown * sizeof(unsigned int));
+        if (choices == NULL) {
+            return 0;
+        }
+        ballots->choices = choices;
+        ballots->choice_capacity = grown;
+    }
+    ballots->choices[ballots->choice_count++] = choice;
+    return 1;
+}
+
+// Releases everything loadRankedBallots() allocated
+void freeRankedBallots(RankedBallots *ballots) {
+    free(ballots->choices);
+    free(ballots->offsets);
+    free(ballots->cursor);
+    free(ballots->next);
+    memset(ballots, 0, sizeof(*ballots));
+}
+
+// Shows live progress (merged from the shards) until every producer has finished
+void waitForProducers(ThreadHandle *threads, int thread_count, double start_time) {
+    double last_report = start_time;
+    while (atomic_load(&vote_shards.finished) < vote_shards.shard_count) {
+        sleepMillis(10);
+        if (nowSeconds() - last_report < 0.5) {
+            continue;
+        }
+        last_report = nowSeconds();
+        int leader = 0;
+        for (int i = 1; i < candidate_count; i++) {
+            if (candidateVotes(i) > candidateVotes(leader)) {
+                leader = i;
+            }
+        }
+        printf("  %.2fs: %lld ballots counted, leading: %s\n",
+               nowSeconds() - start_time, pendingShardVotes(), candidates[leader].name);
+    }
+    for (int i = 0; i < thread_count; i++) {
+        joinThread(threads[i]);
+    }
+}
+
+// Allocates zeroed, cache-line padded counter rows for `shard_count` producers.
+// Returns 0 on allocation failure. No candidates may be added until endIngestion().
+int beginIngestion(int shard_count) {
+    int per_line = CACHE_LINE_SIZE / (int)sizeof(atomic_llong);
+    int stride = (candidate_count + per_line - 1) / per_line * per_line;
+    size_t bytes = (size_t)shard_count * stride * sizeof(atomic_llong);
+
+    void *block = calloc(1, bytes + CACHE_LINE_SIZE);
+    if (block == NULL) {
+        return 0;
+    }
+    uintptr_t aligned = ((uintptr_t)block + CACHE_LINE_SIZE - 1) & ~(uintptr_t)(CACHE_LINE_SIZE - 1);
+
+    vote_shards.block = block;
+    vote_shards.counts = (atomic_llong *)aligned;
+    vote_shards.stride = stride;
+    vote_shards.shard_count = shard_count;
+    vote_shards.active = 1;
+    atomic_store(&vote_shards.finished, 0);
+    return 1;
+}
+
+// Folds every shard into the candidate totals and releases the shard table.
+// Must only be called once all producers have been joined.
+void endIngestion() {
+    if (!vote_shards.active) {
+        return;
+    }
+    unsigned long long last_record = 0;
     for (int i = 0; i < candidate_count; i++) {
-        if (candidates[i].votes == max_votes) {
-            printf("Winner: %s with %d votes!\n", candidates[i].name, max_votes);
+        long long merged = candidateVotes(i);
+        if (merged != candidates[i].votes) {
+            last_record = journalBulkVotes(i, merged - candidates[i].votes);
         }
+        candidates[i].votes = merged;
     }
-    printf("----------------------\n");
+    if (!journalWaitDurable(last_record)) {
+        printf("Warning: The ingested votes could not be saved to %s.\n", JOURNAL_FILE);
+    }
+    free(vote_shards.block);
+    vote_shards.block = NULL;
+    vote_shards.counts = NULL;
+    vote_shards.active = 0;
+    rebuildRanking();
+}
+
+// Current vote total for a candidate, merging in any shards still being filled
+long long candidateVotes(int index) {
+    long long total = candidates[index].votes;
+    if (vote_shards.active) {
+        for (int s = 0; s < vote_shards.shard_count; s++) {
+            total += atomic_load_explicit(&vote_shards.counts[(size_t)s * vote_shards.stride + index],
+                                          memory_order_relaxed);
+        }
+    }
+    return total;
+}
+
+// Total number of ballots sitting in the shards that have not been folded yet
+long long pendingShardVotes() {
+    long long total = 0;
+    if (vote_shards.active) {
+        for (int i = 0; i < candidate_count; i++) {
+            total += candidateVotes(i) - candidates[i].votes;
+        }
+    }
+    return total;
+}
+
+// ---------------------------------- Vote journal -----------------------------------
+
+// Replays JOURNAL_FILE (if any), compacts it when it is torn or large, and
+// starts the group-commit flusher. Returns 0 if votes will not be persisted.
+int openJournal() {
+    MappedFile file;
+    size_t valid_end = 0;
+    long long records = 0;
+    int needs_snapshot = 1; // A missing journal is created as an empty snapshot
+
+    if (mapFile(JOURNAL_FILE, &file)) {
+        double start = nowSeconds();
+        if (file.size < 8 || memcmp(file.data, JOURNAL_MAGIC, 8) != 0) {
+            unmapFile(&file);
+            printf("Error: %s is not a vote journal; votes will not be saved.\n", JOURNAL_FILE);
+            return 0;
+        }
+        if (!replayJournal(file.data, file.size, &valid_end, &records)) {
+            unmapFile(&file);
+            printf("Error: Not enough memory to replay %s; votes will not be saved.\n", JOURNAL_FILE);
+            return 0;
+        }
+        rebuildRanking();
+        needs_snapshot = valid_end < file.size || file.size > JOURNAL_COMPACT_BYTES;
+        if (valid_end < file.size) {
+            printf("Discarded %zu bytes of an incomplete write at the end of %s.\n",
+                   file.size - valid_end, JOURNAL_FILE);
+        }
+        unmapFile(&file);
+        printf("Recovered %d candidates from %lld journal records in %.3f seconds.\n",
+               candidate_count, records, nowSeconds() - start);
+        printf("Press Enter to continue...");
+        getchar();
+    }
+
+    if (needs_snapshot && !writeJournalSnapshot(JOURNAL_FILE)) {
+        printf("Error: Could not write %s; votes will not be saved.\n", JOURNAL_FILE);
+        return 0;
+    }
+    vote_journal.file = fopen(JOURNAL_FILE, "ab");
+    if (vote_journal.file == NULL) {
+        printf("Error: Could not open %s; votes will not be saved.\n", JOURNAL_FILE);
+        return 0;
+    }
+
+    initMutex(&vote_journal.lock);
+    initCondition(&vote_journal.work);
+    initCondition(&vote_journal.durable);
+    if (!startThread(&vote_journal.flusher, journalFlusher, NULL)) {
+        fclose(vote_journal.file);
+        vote_journal.file = NULL;
+        printf("Error: Could not start the journal writer; votes will not be saved.\n");
+        return 0;
+    }
+    return 1;
+}
+
+// Flushes everything still pending, stops the flusher and compacts a large journal
+void closeJournal() {
+    if (vote_journal.file == NULL) {
+        return;
+    }
+    lockMutex(&vote_journal.lock);
+    vote_journal.stopping = 1;
+    signalCondition(&vote_journal.work);
+    unlockMutex(&vote_journal.lock);
+    joinThread(vote_journal.flusher);
+
+    long size = ftell(vote_journal.file);
+    fclose(vote_journal.file);
+    vote_journal.file = NULL;
+    if (size > JOURNAL_COMPACT_BYTES) {
+        writeJournalSnapshot(JOURNAL_FILE);
+    }
+}
+
+// Applies every intact block in a journal image. *valid_end is set to the end
+// of the last block whose checksum matched; anything after it is a torn write.
+// Returns 0 if memory ran out.
+int replayJournal(const unsigned char *data, size_t size, size_t *valid_end, long long *records) {
+    size_t pos = 8;
+    *valid_end = pos;
+
+    while (size - pos >= JOURNAL_BLOCK_HEADER) {
+        uint32_t length = getU32(data + pos + 4);
+        if (getU32(data + pos) != JOURNAL_BLOCK_TAG || length > size - pos - JOURNAL_BLOCK_HEADER) {
+            break;
+        }
+        const unsigned char *p = data + pos + JOURNAL_BLOCK_HEADER;
+        const unsigned char *end = p + length;
+        if (crc32(p, length) != getU32(data + pos + 8)) {
+            break;
+        }
+
+        while (p < end) {
+            if (*p == 'V' && end - p >= 5) {
+                uint32_t index = getU32(p + 1);
+                if (index < (uint32_t)candidate_count) {
+                    candidates[index].votes++;
+                }
+                p += 5;
+            } else if (*p == 'B' && end - p >= 13) {
+                uint32_t index = getU32(p + 1);
+                long long count = (long long)((uint64_t)getU32(p + 5) | (uint64_t)getU32(p + 9) << 32);
+                if (index < (uint32_t)candidate_count) {
+                    candidates[index].votes += count;
+                }
+                p += 13;
+            } else if (*p == 'C' && end - p >= 2 && p[1] < MAX_NAME_LENGTH && end - p >= 2 + p[1]) {
+                char name[MAX_NAME_LENGTH];
+                memcpy(name, p + 2, p[1]);
+                name[p[1]] = 0;
+                if (registerCandidate(name) == REGISTER_NO_MEMORY) {
+                    return 0;
+                }
+                p += 2 + p[1];
+            } else {
+                break; // Unknown record; the checksum matched so this is a newer format
+            }
+            (*records)++;
+        }
+        pos += JOURNAL_BLOCK_HEADER + length;
+        *valid_end = pos;
+    }
+    return 1;
+}
+
+// Atomically replaces `path` with a journal holding just the current state:
+// one 'C' record per candidate and one 'B' record per non-zero tally.
+int writeJournalSnapshot(const char *path) {
+    char temp_path[260];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+
+    size_t capacity = (size_t)candidate_count * (2 + MAX_NAME_LENGTH + 13) + 1;
+    unsigned char *payload = malloc(capacity);
+    FILE *file = fopen(temp_path, "wb");
+    if (payload == NULL || file == NULL) {
+        free(payload);
+        if (file != NULL) fclose(file);
+        return 0;
+    }
+
+    size_t length = 0;
+    for (int i = 0; i < candidate_count; i++) {
+        size_t name_length = strlen(candidates[i].name);
+        payload[length] = 'C';
+        payload[length + 1] = (unsigned char)name_length;
+        memcpy(payload + length + 2, candidates[i].name, name_length);
+        length += 2 + name_length;
+    }
+    for (int i = 0; i < candidate_count; i++) {
+        if (candidates[i].votes != 0) {
+            payload[length] = 'B';
+            putU32(payload + length + 1, (uint32_t)i);
+            putU32(payload + length + 5, (uint32_t)candidates[i].votes);
+            putU32(payload + length + 9, (uint32_t)((uint64_t)candidates[i].votes >> 32));
+            length += 13;
+        }
+    }
+
+    int ok = fwrite(JOURNAL_MAGIC, 1, 8, file) == 8;
+    if (ok && length > 0) {
+        ok = writeJournalBlock(file, payload, length);
+    }
+    ok = syncFile(file) && ok;
+    ok = fclose(file) == 0 && ok;
+    free(payload);
+    return ok && replaceFile(temp_path, path);
+}
+
+// Writes one checksummed block (not synced). Returns 0 on failure.
+int writeJournalBlock(FILE *file, const unsigned char *payload, size_t length) {
+    unsigned char header[JOURNAL_BLOCK_HEADER];
+    putU32(header, JOURNAL_BLOCK_TAG);
+    putU32(header + 4, (uint32_t)length);
+    putU32(header + 8, crc32(payload, length));
+    return fwrite(header, 1, sizeof(header), file) == sizeof(header)
+        && fwrite(payload, 1, length, file) == length;
+}
+
+// Queues one record for the next group commit and returns its sequence
+// number, or 0 if journaling is off or the record could not be queued.
+unsigned long long journalAppend(const unsigned char *record, size_t length) {
+    if (vote_journal.file == NULL) {
+        return 0;
+    }
+    unsigned long long sequence = 0;
+    lockMutex(&vote_journal.lock);
+    if (vote_journal.pending_size + length > vote_journal.pending_capacity) {
+        size_t grown = vote_journal.pending_capacity ? vote_journal.pending_capacity * 2 : 4096;
+        unsigned char *buffer = realloc(vote_journal.pending, grown);
+        if (buffer == NULL) {
+            vote_journal.failed = 1;
+            unlockMutex(&vote_journal.lock);
+            return 0;
+        }
+        vote_journal.pending = buffer;
+        vote_journal.pending_capacity = grown;
+    }
+    memcpy(vote_journal.pending + vote_journal.pending_size, record, length);
+    vote_journal.pending_size += length;
+    sequence = ++vote_journal.appended;
+    signalCondition(&vote_journal.work);
+    unlockMutex(&vote_journal.lock);
+    return sequence;
+}
+
+// Journals a newly registered candidate
+unsigned long long journalCandidate(int index) {
+    unsigned char record[2 + MAX_NAME_LENGTH];
+    size_t length = strlen(candidates[index].name);
+    record[0] = 'C';
+    record[1] = (unsigned char)length;
+    memcpy(record + 2, candidates[index].name, length);
+    return journalAppend(record, 2 + length);
+}
+
+// Journals a single vote
+unsigned long long journalVote(int index) {
+    unsigned char record[5];
+    record[0] = 'V';
+    putU32(record + 1, (uint32_t)index);
+    return journalAppend(record, sizeof(record));
+}
+
+// Journals `count` votes for one candidate at once (used after bulk ingestion)
+unsigned long long journalBulkVotes(int index, long long count) {
+    unsigned char record[13];
+    record[0] = 'B';
+    putU32(record + 1, (uint32_t)index);
+    putU32(record + 5, (uint32_t)count);
+    putU32(record + 9, (uint32_t)((uint64_t)count >> 32));
+    return journalAppend(record, sizeof(record));
+}
+
+// Blocks until the record with this sequence number is on disk. Returns 0 if
+// it could not be made durable; sequence 0 (journaling off) returns at once.
+int journalWaitDurable(unsigned long long sequence) {
+    if (vote_journal.file == NULL) {
+        return 1;
+    }
+    if (sequence == 0) {
+        return !vote_journal.failed;
+    }
+    lockMutex(&vote_journal.lock);
+    while (vote_journal.synced < sequence) {
+        waitCondition(&vote_journal.durable, &vote_journal.lock);
+    }
+    int ok = !vote_journal.failed;
+    unlockMutex(&vote_journal.lock);
+    return ok;
+}
+
+// Flusher thread body: one write + fsync per group of pending records
+THREAD_RETURN journalFlusher(void *arg) {
+    (void)arg;
+    lockMutex(&vote_journal.lock);
+    for (;;) {
+        while (vote_journal.pending_size == 0 && !vote_journal.stopping) {
+            waitCondition(&vote_journal.work, &vote_journal.lock);
+        }
+        if (vote_journal.pending_size == 0) {
+            break; // Shutting down with nothing left to write
+        }
+
+        // Linger briefly so records from concurrent voters join this group
+        unlockMutex(&vote_journal.lock);
+        sleepMillis(GROUP_COMMIT_WINDOW_MS);
+        lockMutex(&vote_journal.lock);
+
+        unsigned char *batch = vote_journal.pending;
+        size_t batch_size = vote_journal.pending_size;
+        size_t batch_capacity = vote_journal.pending_capacity;
+        unsigned long long batch_end = vote_journal.appended;
+        vote_journal.pending = vote_journal.spare;
+        vote_journal.pending_capacity = vote_journal.spare_capacity;
+        vote_journal.pending_size = 0;
+        unlockMutex(&vote_journal.lock);
+
+        int ok = writeJournalBlock(vote_journal.file, batch, batch_size) && syncFile(vote_journal.file);
+
+        lockMutex(&vote_journal.lock);
+        vote_journal.spare = batch;
+        vote_journal.spare_capacity = batch_capacity;
+        if (!ok) {
+            vote_journal.failed = 1;
+        }
+        vote_journal.synced = batch_end;
+        broadcastCondition(&vote_journal.durable);
+    }
+    unlockMutex(&vote_journal.lock);
+    return THREAD_RESULT;
+}
+
+// Standard CRC-32 (IEEE 802.3), table driven
+unsigned int crc32(const unsigned char *data, size_t length) {
+    static unsigned int table[256];
+    static int table_ready = 0;
+    if (!table_ready) {
+        for (unsigned int i = 0; i < 256; i++) {
+            unsigned int c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+        table_ready = 1;
+    }
+    unsigned int crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < length; i++) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+// Stores a uint32 in little-endian byte order
+void putU32(unsigned char *p, uint32_t value) {
+    p[0] = (unsigned char)value;
+    p[1] = (unsigned char)(value >> 8);
+    p[2] = (unsigned char)(value >> 16);
+    p[3] = (unsigned char)(value >> 24);
+}
+
+// Reads a little-endian uint32
+uint32_t getU32(const unsigned char *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+// ------------------------------- Platform helpers --------------------------------
+
+// Maps a whole file read-only. Returns 0 on failure; empty files map to size 0.
+int mapFile(const char *path, MappedFile *file) {
+    file->data = NULL;
+    file->size = 0;
+#ifdef _WIN32
+    LARGE_INTEGER size;
+    file->mapping = NULL;
+    file->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                             FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file->file == INVALID_HANDLE_VALUE) {
+        return 0;
+    }
+    if (!GetFileSizeEx(file->file, &size) || (unsigned long long)size.QuadPart > (size_t)-1) {
+        CloseHandle(file->file);
+        return 0;
+    }
+    file->size = (size_t)size.QuadPart;
+    if (file->size == 0) {
+        return 1;
+    }
+    file->mapping = CreateFileMappingA(file->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (file->mapping != NULL) {
+        file->data = (const unsigned char *)MapViewOfFile(file->mapping, FILE_MAP_READ, 0, 0, 0);
+    }
+    if (file->data == NULL) {
+        unmapFile(file);
+        return 0;
+    }
+#else
+    struct stat st;
+    file->fd = open(path, O_RDONLY);
+    if (file->fd < 0) {
+        return 0;
+    }
+    if (fstat(file->fd, &st) != 0 || (unsigned long long)st.st_size > (size_t)-1) {
+        close(file->fd);
+        return 0;
+    }
+    file->size = (size_t)st.st_size;
+    if (file->size == 0) {
+        return 1;
+    }
+    void *data = mmap(NULL, file->size, PROT_READ, MAP_PRIVATE, file->fd, 0);
+    if (data == MAP_FAILED) {
+        close(file->fd);
+        return 0;
+    }
+    madvise(data, file->size, MADV_SEQUENTIAL);
+    file->data = (const unsigned char *)data;
+#endif
+    return 1;
+}
+
+// Releases a mapping created by mapFile()
+void unmapFile(MappedFile *file) {
+#ifdef _WIN32
+    if (file->data != NULL) UnmapViewOfFile(file->data);
+    if (file->mapping != NULL) CloseHandle(file->mapping);
+    CloseHandle(file->file);
+#else
+    if (file->data != NULL) munmap((void *)file->data, file->size);
+    close(file->fd);
+#endif
+    file->data = NULL;
+    file->size = 0;
+}
+
+// Flushes stdio buffers and forces the file's data to disk. Returns 0 on failure.
+int syncFile(FILE *file) {
+    if (fflush(file) != 0) {
+        return 0;
+    }
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+// Renames `from` over `to`, replacing it atomically. Returns 0 on failure.
+int replaceFile(const char *from, const char *to) {
+#ifdef _WIN32
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return rename(from, to) == 0;
+#endif
+}
+
+void initMutex(Mutex *mutex) {
+#ifdef _WIN32
+    InitializeCriticalSection(mutex);
+#else
+    pthread_mutex_init(mutex, NULL);
+#endif
+}
+
+void lockMutex(Mutex *mutex) {
+#ifdef _WIN32
+    EnterCriticalSection(mutex);
+#else
+    pthread_mutex_lock(mutex);
+#endif
+}
+
+void unlockMutex(Mutex *mutex) {
+#ifdef _WIN32
+    LeaveCriticalSection(mutex);
+#else
+    pthread_mutex_unlock(mutex);
+#endif
+}
+
+void initCondition(Condition *condition) {
+#ifdef _WIN32
+    InitializeConditionVariable(condition);
+#else
+    pthread_cond_init(condition, NULL);
+#endif
+}
+
+// Atomically releases `mutex` and waits; the mutex is held again on return
+void waitCondition(Condition *condition, Mutex *mutex) {
+#ifdef _WIN32
+    SleepConditionVariableCS(condition, mutex, INFINITE);
+#else
+    pthread_cond_wait(condition, mutex);
+#endif
+}
+
+void signalCondition(Condition *condition) {
+#ifdef _WIN32
+    WakeConditionVariable(condition);
+#else
+    pthread_cond_signal(condition);
+#endif
+}
+
+void broadcastCondition(Condition *condition) {
+#ifdef _WIN32
+    WakeAllConditionVariable(condition);
+#else
+    pthread_cond_broadcast(condition);
+#endif
+}
+
+// Starts a thread running func(arg). Returns 0 on failure.
+int startThread(ThreadHandle *thread, ThreadFunc func, void *arg) {
+#ifdef _WIN32
+    *thread = CreateThread(NULL, 0, func, arg, 0, NULL);
+    return *thread != NULL;
+#else
+    return pthread_create(thread, NULL, func, arg) == 0;
+#endif
+}
+
+// Waits for a thread started with startThread() to finish
+void joinThread(ThreadHandle thread) {
+#ifdef _WIN32
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+#else
+    pthread_join(thread, NULL);
+#endif
+}
+
+// Number of logical processors available to this process
+int cpuCount() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#endif
+}
+
+// Sleeps the calling thread for roughly `ms` milliseconds
+void sleepMillis(int ms) {
+#ifdef _WIN32
+    Sleep(ms);
+#else
+    usleep((useconds_t)ms * 1000);
+#endif
+}
+
+// Monotonic wall-clock time in seconds, for throughput measurements
+double nowSeconds() {
+#ifdef _WIN32
+    LARGE_INTEGER freq, now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (double)now.QuadPart / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+#endif
 }
 
 // A utility function to clear the input buffer after using scanf
@@ -1,11 +1,50 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stddef.h> // For offsetof()
+#include <stdint.h>
 #include <time.h>
+#ifdef _WIN32
+#include <windows.h> // For MoveFileExA(), CreateFileMapping()
+#include <io.h>      // For _commit()
+#else
+#include <pthread.h>
+#include <unistd.h>  // For fsync()
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define HAVE_AVX2_KERNEL 1 // Built with target("avx2") and chosen at run time
+#endif
 
-#define MAX_TRANSACTIONS 500
 #define MAX_DESC_LENGTH 100
-#define FILENAME "money_data.dat"
+#define FILENAME "money_data.dat"          // Pre-ledger format, imported on first run
+#define LEDGER_FILENAME "money_ledger.dat"
+#define LOG_FILENAME "money_data.log"
+#define CHECKPOINT_INTERVAL 50 // Fold the log into the ledger after this many appends
+#define LOG_CENTS_MARK 0x43454E54u // "CENT"
+#define LOG_INDEX64_MARK 0x34365849u // "IX64"
+#define LEDGER_MAGIC "MNYLEDGR"
+#define LEDGER_VERSION 2                           // 1 stored one Transaction struct per record
+#define LEDGER_HEADER_SIZE 64                      // Each of the two header slots
+#define LEDGER_DATA_OFFSET (2 * LEDGER_HEADER_SIZE) // Chunks start after both slots
+#define CHUNK_MAGIC "CHNK"
+#define CHUNK_MERGE_RATIO 4 // A checkpoint rewrites trailing chunks smaller than this many times its own rows
+#define NO_CATEGORY UINT32_MAX
+#define PAD8(size) (((size) + 7) & ~(uint64_t)7) // Chunk sections are 8-byte aligned
+#define BENCH_DEFAULT_ROWS 1000000
+#define BENCH_PASSES 20
+#define REPORT_BUFFER_SIZE (1 << 20)
+#define REPORT_ROW_MAX 512 // More than the longest rendered row
+#define IMPORT_MAX_THREADS 64
+#define IMPORT_MIN_CHUNK (64 * 1024) // Smaller statements are not worth splitting further
+#define IMPORT_MAX_FIELDS 32
+#define IMPORT_MAX_LINE 4096         // Longer lines are skipped as malformed
+#define DEFAULT_CATEGORY "Uncategorized"
+#define ROLLUP_MAX_SPAN (1 << 15)  // Keys a rollup table covers densely (about 89 years of days)
+#define ROLLUP_MAX_CELLS (1 << 22) // Dense cells per rollup table, over all rows
 
 // Enum to define the type of transaction
 typedef enum {
@@ -13,29 +52,396 @@ typedef enum {
     EXPENSE
 } TransactionType;
 
-// Structure to hold details of a single transaction
+// Structure to hold details of a single transaction as it is entered, logged
+// or imported. The ledger itself keeps transactions column by column.
 typedef struct {
-    double amount;
+    int64_t amount;          // In cents
     TransactionType type;
     char category[MAX_DESC_LENGTH];
     char description[MAX_DESC_LENGTH];
     time_t transaction_time;
 } Transaction;
 
-// Global array to store all transactions and a counter
-Transaction transactions[MAX_TRANSACTIONS];
-int transaction_count = 0;
+// One entry of the append-only transaction log. Current records have
+// LOG_INDEX64_MARK mixed into their checksum. Older ones have a 32-bit index
+// in the first four bytes, and either LOG_CENTS_MARK or, before amounts were
+// kept in cents, a double amount and no mark; they are converted on replay.
+typedef struct {
+    int64_t index;           // Position of the transaction in the ledger
+    Transaction transaction;
+    unsigned int checksum;   // Over index and transaction, to detect a torn append
+} LogRecord;
+
+// A run of consecutive transactions stored as columns, so a scan only touches
+// the columns it needs. Blocks loaded from the ledger point into the mapped
+// file; the last block is growable and takes new transactions.
+typedef struct {
+    long long first_row;       // Ledger index of this block's row 0
+    long long count;
+    long long capacity;        // 0 for mapped (read-only) blocks
+    int64_t *amounts;          // Integer cents
+    int64_t *times;            // Seconds since the epoch
+    uint64_t *desc_ends;       // Row i's description ends before desc_heap[desc_ends[i]]
+    uint64_t *expense_bits;    // Bit i is set when row i is an expense
+    uint32_t *category_ids;    // Index into category_names
+    char *desc_heap;           // Descriptions back to back, each NUL-terminated
+    uint64_t desc_heap_size;
+    uint64_t desc_heap_capacity;
+} TransactionBlock;
+
+// Aggregates over a set of transactions, all amounts in cents
+typedef struct {
+    int64_t income;
+    int64_t expense;
+    int64_t net;
+    long long count;
+    int64_t min;    // Smallest single amount
+    int64_t max;    // Largest single amount
+} SummaryTotals;
+
+// Income, expense and count of the transactions in one rollup bucket, in cents
+typedef struct {
+    int64_t income;
+    int64_t expense;
+    long long count;
+} RollupCell;
+
+// A timestamp broken into its local date and time of day
+typedef struct {
+    long long year;
+    int month;      // 1-12
+    int day;        // 1-31
+    int minute;     // Minutes since local midnight
+} LocalTime;
+
+// A rollup bucket kept outside the dense range of its table
+typedef struct {
+    long long key;
+    int row;        // -1 marks an empty slot
+    RollupCell cell;
+} RollupOutlier;
+
+// A growable table of rollup buckets: `rows` rows (one per category, or just
+// one) by `span` consecutive keys (day or month numbers) starting at `first`.
+// Keys too far from the rest for the dense range (a mistyped year, say) go
+// to a small open-addressing table of outliers instead.
+typedef struct {
+    RollupCell *cells;
+    int rows;
+    long long first;
+    long long span;
+    RollupOutlier *outliers;
+    int outlier_slots;  // A power of two, kept at most half full
+    int outlier_count;
+} RollupTable;
+
+// A row and its timestamp, used while sorting rows into time order
+typedef struct {
+    int64_t time;
+    long long row;
+} TimeKey;
+
+// Formats report rows into one large reusable buffer and writes it out in
+// big chunks, instead of a printf() per row
+typedef struct {
+    FILE *out;
+    char *buffer;
+    size_t used;
+    int failed;
+} ReportWriter;
+
+#ifdef _WIN32
+typedef HANDLE ThreadHandle;
+typedef LPTHREAD_START_ROUTINE ThreadFunc;
+#define THREAD_RETURN DWORD WINAPI
+#define THREAD_RESULT 0
+#else
+typedef pthread_t ThreadHandle;
+typedef void *(*ThreadFunc)(void *);
+#define THREAD_RETURN void *
+#define THREAD_RESULT NULL
+#endif
+
+// Which column of a bank statement holds each field; -1 if none does
+typedef struct {
+    int date;
+    int amount;
+    int debit;        // Some banks export separate debit and credit columns
+    int credit;
+    int type;
+    int category;
+    int description;
+} ImportLayout;
+
+// One parser thread's share of a statement and the rows it parsed from it.
+// Category names are interned per thread and only mapped to ledger ids when
+// the results are merged, so the threads share nothing while they run.
+typedef struct {
+    const unsigned char *begin;
+    const unsigned char *end;
+    const ImportLayout *layout;
+    long long count;
+    long long capacity;
+    int64_t *amounts;
+    int64_t *times;
+    unsigned char *is_expense;
+    uint32_t *categories;      // Thread-local category ids
+    size_t *descriptions;      // Offset of each row's description in text
+    char *text;                // Descriptions and category names, NUL-terminated
+    size_t text_size;
+    size_t text_capacity;
+    size_t *category_names;    // Offset of each local category's name in text
+    uint32_t category_count;
+    uint32_t category_capacity;
+    uint32_t *category_index;  // Open addressing over local id + 1
+    uint32_t category_index_size;
+    int cached_year, cached_month, cached_day; // Last date seen, and its local midnight
+    time_t cached_midnight;
+    int cached_whole_day;         // The cached day is 86400 s long (no DST change)
+    long long skipped;         // Lines that could not be parsed
+    int out_of_memory;
+} ImportChunk;
+
+// Header of the ledger file. There are two slots at the start of the file and
+// each commit overwrites the older one, so a torn header write always leaves
+// the previous commit intact. Chunks follow at LEDGER_DATA_OFFSET.
+typedef struct {
+    char magic[8];            // LEDGER_MAGIC
+    uint32_t version;         // LEDGER_VERSION
+    uint32_t chunk_count;     // Live chunks, linked backwards from last_chunk_offset
+    uint64_t count;           // Committed transactions
+    uint64_t generation;      // Bumped on every commit; the newer valid slot wins
+    uint64_t last_chunk_offset;
+    uint64_t end_offset;      // Bytes past this belong to an unfinished commit
+    uint32_t category_count;
+    uint32_t data_checksum;   // CRC-32 of bytes [LEDGER_DATA_OFFSET, end_offset)
+    uint32_t reserved;
+    uint32_t header_checksum; // CRC-32 of the fields above
+} LedgerHeader;
+
+// Header of a version 1 ledger, kept to convert old files
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t count;
+    uint64_t generation;
+    uint32_t data_checksum;
+    uint32_t header_checksum;
+    char reserved[24];
+} LedgerHeaderV1;
+
+// A chunk holds the columns of a range of rows, in this order and each padded
+// to 8 bytes: amounts, times, desc_ends, expense_bits, category_ids,
+// desc_heap, then the names of the categories these rows introduced.
+typedef struct {
+    char magic[4];            // CHUNK_MAGIC
+    uint32_t first_category;  // Id of the first name stored here
+    uint32_t new_categories;
+    uint32_t header_checksum; // CRC-32 of this header with this field zeroed
+    uint64_t first_row;
+    uint64_t rows;
+    uint64_t prev_offset;     // Previous live chunk, 0 for the first
+    uint64_t desc_heap_size;
+    uint64_t category_bytes;
+    uint64_t total_size;      // Whole chunk including this header
+} ChunkHeader;
+
+// Where one live chunk of the ledger file is and what it covers
+typedef struct {
+    uint64_t offset;
+    uint64_t first_row;
+    uint64_t rows;
+    uint64_t total_size;
+    uint32_t first_category;
+} ChunkInfo;
+
+// Columns in the order they are laid out in a chunk
+enum {
+    COLUMN_AMOUNTS,
+    COLUMN_TIMES,
+    COLUMN_DESC_ENDS,
+    COLUMN_EXPENSE_BITS,
+    COLUMN_CATEGORY_IDS,
+    COLUMN_DESC_HEAP,
+    COLUMN_COUNT
+};
+
+// A read-only view of a whole file mapped into memory
+typedef struct {
+    const unsigned char *data;
+    size_t size;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#else
+    int fd;
+#endif
+} MappedFile;
+
+// All transactions: one mapped block per ledger chunk, then the growable block
+MappedFile ledger_map;
+TransactionBlock *blocks = NULL;
+int block_count = 0;
+long long transaction_count = 0;
+
+// Interned category names. Rows store a 32-bit id instead of the text;
+// category_index finds ids by name with open addressing (slots hold id + 1).
+char **category_names = NULL;
+uint32_t category_count = 0;
+uint32_t category_capacity = 0;
+uint32_t *category_index = NULL;
+uint32_t category_index_size = 0;
+
+// Rollups kept up to date as transactions are added, so period and category
+// reports never rescan the ledger. Days count from 1970-01-01 and months from
+// year 0, both in local time.
+RollupTable day_totals;
+RollupTable month_totals;
+RollupTable category_months; // One row per category id
+
+// Ledger rows in transaction_time order, for date-range queries. While rows
+// arrive in time order (the usual case) that is the identity and no array is
+// kept. The first row that arrives out of order switches to an explicit
+// permutation, which is extended and re-sorted lazily when a query needs it.
+int time_order_identity = 1;
+int64_t last_row_time = INT64_MIN;
+long long *time_order = NULL;
+long long time_order_rows = 0; // Rows covered by time_order
+
+// Shared by every report; the program only renders one at a time
+char report_buffer[REPORT_BUFFER_SIZE];
+
+// Last committed ledger header, the slot it lives in, how many transactions
+// it covers, and the live chunks it links to
+LedgerHeader ledger_header;
+int ledger_slot = 0;
+long long saved_count = 0;
+ChunkInfo *chunks = NULL;
+int chunk_count = 0;
+int chunk_capacity = 0;
+
+// Log of transactions added since the last checkpoint of the ledger
+FILE *log_file = NULL;
+int logged_since_checkpoint = 0;
 
 // Function Prototypes
 void addTransaction();
 void viewTransactions();
 void displaySummary();
-void saveDataToFile();
+int saveDataToFile();
 void loadDataFromFile();
+void verifyLedger();
+void compactLedger();
+void summarizeTransactions(SummaryTotals *totals);
+void summarizeRows(const TransactionBlock *block, long long from, long long to, SummaryTotals *totals);
+void summarizeRowsAVX2(const TransactionBlock *block, long long from, long long to, SummaryTotals *totals);
+int useAVX2();
+int runBenchmark(long long rows);
+void showReports();
+void reportCategoriesForMonth();
+void reportMonthlyNet();
+void reportDailyTotals();
+int findRollupCells(int64_t when, uint32_t category, RollupCell *cells[3]);
+void addToRollups(RollupCell *cells[3], int64_t amount, int is_expense);
+int indexBlock(const TransactionBlock *block);
+void noteRowTime(int64_t when);
+int ensureTimeOrder();
+long long lowerBoundTime(int64_t when);
+long long orderedRow(long long position);
+int64_t rowTime(long long index);
+int compareTimeKeys(const void *a, const void *b);
+void viewDateRange();
+void summarizeOrderedRange(long long from, long long to, SummaryTotals *totals);
+void exportTransactions();
+void importStatement();
+int importStatementFile(const char *path, int thread_count);
+THREAD_RETURN importWorker(void *arg);
+int storeImportedRow(ImportChunk *chunk, int64_t cents, int is_expense, int64_t when,
+                     const char *category, size_t category_length,
+                     const char *description, size_t description_length);
+uint32_t internLocalCategory(ImportChunk *chunk, const char *name, size_t length);
+size_t appendChunkText(ImportChunk *chunk, const char *text, size_t length);
+void freeImportChunk(ImportChunk *chunk);
+int splitCsvLine(const char *line, size_t length, char *scratch, const char **fields, size_t *lengths);
+int readImportLayout(const char **fields, const size_t *lengths, int count, ImportLayout *layout);
+int fieldContains(const char *field, size_t length, const char *word);
+int typeDirection(const char *type, size_t length);
+int parseCents(const char *text, size_t length, int64_t *cents);
+int parseStatementDate(ImportChunk *chunk, const char *text, size_t length, int64_t *when);
+int startThread(ThreadHandle *thread, ThreadFunc func, void *arg);
+void joinThread(ThreadHandle thread);
+int cpuCount();
+void startReport(ReportWriter *writer, FILE *out);
+void renderTableHeader(ReportWriter *writer);
+void renderTableRule(ReportWriter *writer);
+void renderTransactionRow(ReportWriter *writer, const TransactionBlock *block, long long row);
+void renderText(ReportWriter *writer, const char *text, size_t length, size_t width);
+int flushReport(ReportWriter *writer);
+size_t formatLocalTime(int64_t when, char *out);
+size_t formatCents(int64_t cents, char *out);
+const char *centsText(int64_t cents, char *out);
+size_t formatInteger(long long value, char *out);
+int readDate(const char *prompt, time_t *midnight);
+RollupCell *rollupCell(RollupTable *table, int row, long long key);
+const RollupCell *peekRollupCell(const RollupTable *table, int row, long long key);
+RollupOutlier *findRollupOutlier(const RollupTable *table, int row, long long key);
+RollupCell *addRollupOutlier(RollupTable *table, int row, long long key);
+unsigned int outlierHash(int row, long long key);
+long long localDayNumber(time_t when, long long *month);
+int localTimeParts(time_t when, LocalTime *parts);
+long long daysFromCivil(long long year, int month, int day);
+int localMidnight(int year, int month, int day, time_t *midnight);
+int readYearMonth(long long *month);
+int appendTransaction(const Transaction *transaction);
+int64_t centsFromDouble(double amount);
+int appendRow(int64_t cents, int is_expense, int64_t when, uint32_t category,
+              const char *description, size_t description_length);
+TransactionBlock *locateRow(long long index, long long *row);
+const char *rowDescription(const TransactionBlock *block, long long row);
+int addGrowableBlock();
+uint32_t internCategory(const char *name);
+int addCategoryName(char *name);
+int rebuildCategoryIndex();
+int openLedger();
+int attachChunks();
+int checkBlock(const TransactionBlock *block);
+int convertLedgerV1();
+int createLedger();
+int writeLedgerHeader(FILE *file, int slot, const LedgerHeader *header);
+int writeLedgerSnapshot(const char *path, LedgerHeader *header, ChunkInfo *chunk);
+int writeChunk(FILE *file, long long first_row, long long rows, uint32_t first_category,
+               uint64_t prev_offset, unsigned int *crc, uint64_t *size);
+int writeColumn(FILE *file, int column, long long first_row, long long rows, unsigned int *crc);
+int writeTracked(FILE *file, const void *data, size_t length, unsigned int *crc);
+int rememberChunk(const ChunkInfo *chunk);
+uint64_t chunkSize(uint64_t rows, uint64_t desc_heap_size, uint64_t category_bytes);
+long long importLegacyData(const char *path);
+void appendToLog(const Transaction *transaction, long long index);
+int logRows(long long first);
+void rowTransaction(long long index, Transaction *transaction);
+long long replayLog();
+void openLog();
+unsigned int checksumBytes(const void *data, size_t length);
+unsigned int crc32Update(unsigned int crc, const void *data, size_t length);
+int syncFile(FILE *file);
+int seekFile(FILE *file, long long offset);
+int replaceFile(const char *from, const char *to);
+int mapFile(const char *path, MappedFile *file);
+void unmapFile(MappedFile *file);
 void displayMenu();
 void clearInputBuffer();
+double nowSeconds();
+
+int main(int argc, char *argv[]) {
+    if (argc > 1) {
+        if (strcmp(argv[1], "--bench") == 0) {
+            return runBenchmark(argc > 2 ? atoll(argv[2]) : BENCH_DEFAULT_ROWS);
+        }
+        printf("Usage: %s [--bench [ROWS]]\n", argv[0]);
+        return 1;
+    }
 
-int main() {
     // Load existing data from the file when the program starts
     loadDataFromFile();
 
@@ -63,20 +469,36 @@ int main() {
                 displaySummary();
                 break;
             case 4:
+                verifyLedger();
+                break;
+            case 5:
+                showReports();
+                break;
+            case 6:
+                viewDateRange();
+                break;
+            case 7:
+                exportTransactions();
+                break;
+            case 8:
+                importStatement();
+                break;
+            case 9:
                 // Save data before exiting
                 saveDataToFile();
+                compactLedger();
                 printf("Data saved. Exiting Money Manager. Goodbye!\n");
                 break;
             default:
-                printf("Invalid choice! Please select a valid option (1-4).\n");
+                printf("Invalid choice! Please select a valid option (1-9).\n");
         }
 
-        if (choice != 4) {
+        if (choice != 9) {
             printf("\nPress Enter to return to the menu...");
             getchar();
         }
 
-    } while (choice != 4);
+    } while (choice != 9);
 
     return 0;
 }
@@ -88,20 +510,21 @@ void displayMenu() {
     printf("1. Add Transaction (Income/Expense)\n");
     printf("2. View All Transactions\n");
     printf("3. Display Summary\n");
-    printf("4. Save and Exit\n");
+    printf("4. Verify Ledger Integrity\n");
+    printf("5. Reports\n");
+    printf("6. Transactions in a Date Range\n");
+    printf("7. Export Transactions to File\n");
+    printf("8. Import Bank Statement (CSV)\n");
+    printf("9. Save and Exit\n");
     printf("==========================================\n");
     printf("Enter your choice: ");
 }
 
 // Adds a new income or expense transaction
 void addTransaction() {
-    if (transaction_count >= MAX_TRANSACTIONS) {
-        printf("Transaction limit reached. Cannot add more.\n");
-        return;
-    }
-
     Transaction new_trans;
     int type_choice;
+    memset(&new_trans, 0, sizeof(new_trans)); // Padding is checksummed in the log
 
     printf("--- Add New Transaction ---\n");
     printf("Enter transaction type (1 for Income, 2 for Expense): ");
@@ -117,9 +540,19 @@ void addTransaction() {
         return;
     }
 
+    char amount[64];
     printf("Enter amount: ");
-    scanf("%lf", &new_trans.amount);
-    clearInputBuffer();
+    if (fgets(amount, sizeof(amount), stdin) == NULL) {
+        return;
+    }
+    if (strchr(amount, '\n') == NULL) {
+        clearInputBuffer();
+    }
+    amount[strcspn(amount, "\r\n")] = 0; // Remove newline
+    if (!parseCents(amount, strlen(amount), &new_trans.amount) || new_trans.amount <= 0) {
+        printf("Invalid amount. Enter a positive amount, e.g. 1234.56.\n");
+        return;
+    }
 
     printf("Enter category (e.g., Salary, Groceries, Rent): ");
     fgets(new_trans.category, MAX_DESC_LENGTH, stdin);
@@ -131,8 +564,11 @@ void addTransaction() {
 
     new_trans.transaction_time = time(NULL); // Record current time
 
-    transactions[transaction_count] = new_trans;
-    transaction_count++;
+    if (!appendTransaction(&new_trans)) {
+        printf("Error: Not enough memory to add the transaction.\n");
+        return;
+    }
+    appendToLog(&new_trans, transaction_count - 1);
 
     printf("\nTransaction added successfully!\n");
 }
@@ -145,87 +581,2614 @@ void viewTransactions() {
     }
 
     printf("--- All Transactions ---\n");
-    printf("%-5s | %-12s | %-15s | %-20s | %-25s\n", "ID", "Type", "Amount", "Category", "Description");
-    printf("--------------------------------------------------------------------------------------\n");
+    ReportWriter writer;
+    startReport(&writer, stdout);
+    renderTableHeader(&writer);
+    for (int b = 0; b < block_count; b++) {
+        for (long long r = 0; r < blocks[b].count; r++) {
+            renderTransactionRow(&writer, &blocks[b], r);
+        }
+    }
+    renderTableRule(&writer);
+    flushReport(&writer);
+}
+
+// Writes every transaction to a text file in the same layout as the list
+void exportTransactions() {
+    char path[260];
+    printf("Enter the file name to export to: ");
+    if (fgets(path, sizeof(path), stdin) == NULL) {
+        return;
+    }
+    path[strcspn(path, "\n")] = 0; // Remove newline
+    if (path[0] == 0) {
+        printf("No file name given.\n");
+        return;
+    }
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        printf("Error: Could not open file %s for writing.\n", path);
+        return;
+    }
 
-    for (int i = 0; i < transaction_count; i++) {
-        char time_str[30];
-        strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M", localtime(&transactions[i].transaction_time));
-        
-        printf("%-5d | %-12s | $%-14.2f | %-20s | %-25s\n",
-               i + 1,
-               (transactions[i].type == INCOME) ? "Income" : "Expense",
-               transactions[i].amount,
-               transactions[i].category,
-               transactions[i].description);
+    double start = nowSeconds();
+    ReportWriter writer;
+    startReport(&writer, file);
+    renderTableHeader(&writer);
+    for (int b = 0; b < block_count; b++) {
+        for (long long r = 0; r < blocks[b].count; r++) {
+            renderTransactionRow(&writer, &blocks[b], r);
+        }
     }
-    printf("--------------------------------------------------------------------------------------\n");
+    int ok = flushReport(&writer);
+    ok = fclose(file) == 0 && ok;
+    if (!ok) {
+        printf("Error: Could not write %s.\n", path);
+        return;
+    }
+    printf("Exported %lld transactions to %s in %.2f seconds.\n", transaction_count, path, nowSeconds() - start);
 }
 
-// Calculates and displays the financial summary
-void displaySummary() {
-    if (transaction_count == 0) {
-        printf("No data for summary. Please add a transaction first.\n");
+// Asks for a CSV bank statement and imports every transaction in it
+void importStatement() {
+    char path[260];
+    printf("CSV columns are found by header names (date, amount or debit/credit, type,\n");
+    printf("category, description/memo/payee); without a header they are\n");
+    printf("date,amount,category,description. Dates are YYYY-MM-DD [HH:MM[:SS]] and\n");
+    printf("negative amounts are expenses unless a type or debit column says otherwise.\n");
+    printf("Enter the file name to import: ");
+    if (fgets(path, sizeof(path), stdin) == NULL) {
+        return;
+    }
+    path[strcspn(path, "\n")] = 0; // Remove newline
+    if (path[0] == 0) {
+        printf("No file name given.\n");
         return;
     }
+    int thread_count = cpuCount();
+    if (thread_count > IMPORT_MAX_THREADS) {
+        thread_count = IMPORT_MAX_THREADS;
+    }
+    importStatementFile(path, thread_count);
+}
+
+// Maps a CSV statement, splits it at line boundaries into one chunk per
+// thread, parses the chunks in parallel, then appends all rows in file order
+// and checkpoints the ledger once. Returns 0 on failure.
+int importStatementFile(const char *path, int thread_count) {
+    MappedFile file;
+    if (!mapFile(path, &file)) {
+        printf("Error: Could not open file %s for reading.\n", path);
+        return 0;
+    }
+    double start = nowSeconds();
+    const unsigned char *begin = file.data;
+    const unsigned char *end = file.data + file.size;
+    if (file.size >= 3 && memcmp(begin, "\xEF\xBB\xBF", 3) == 0) {
+        begin += 3; // UTF-8 byte order mark
+    }
+
+    // A first line naming a date and an amount column is a header
+    ImportLayout layout = { 0, 1, -1, -1, -1, 2, 3 };
+    const unsigned char *nl = memchr(begin, '\n', (size_t)(end - begin));
+    const unsigned char *first_end = nl ? nl : end;
+    if (first_end - begin < IMPORT_MAX_LINE) {
+        char scratch[IMPORT_MAX_LINE];
+        const char *fields[IMPORT_MAX_FIELDS];
+        size_t lengths[IMPORT_MAX_FIELDS];
+        int count = splitCsvLine((const char *)begin, (size_t)(first_end - begin), scratch, fields, lengths);
+        if (readImportLayout(fields, lengths, count, &layout)) {
+            begin = nl ? nl + 1 : end;
+        }
+    }
+
+    if ((end - begin) / IMPORT_MIN_CHUNK < thread_count) {
+        thread_count = (int)((end - begin) / IMPORT_MIN_CHUNK) + 1;
+    }
+    ImportChunk chunks[IMPORT_MAX_THREADS];
+    const unsigned char *cursor = begin;
+    for (int i = 0; i < thread_count; i++) {
+        const unsigned char *stop = end;
+        if (i < thread_count - 1) {
+            stop = begin + (end - begin) / thread_count * (i + 1);
+            nl = stop > cursor ? memchr(stop, '\n', (size_t)(end - stop)) : NULL;
+            stop = stop <= cursor ? cursor : (nl ? nl + 1 : end);
+        }
+        memset(&chunks[i], 0, sizeof(ImportChunk));
+        chunks[i].begin = cursor;
+        chunks[i].end = stop;
+        chunks[i].layout = &layout;
+        cursor = stop;
+    }
+
+    ThreadHandle threads[IMPORT_MAX_THREADS];
+    int started = 0;
+    for (; started < thread_count - 1; started++) {
+        if (!startThread(&threads[started], importWorker, &chunks[started])) {
+            break;
+        }
+    }
+    for (int i = started; i < thread_count; i++) {
+        importWorker(&chunks[i]);
+    }
+    for (int i = 0; i < started; i++) {
+        joinThread(threads[i]);
+    }
+    double parsed = nowSeconds();
+
+    // Merge in file order, mapping each thread's category ids to ledger ids
+    long long first_row = transaction_count;
+    long long imported = 0, skipped = 0;
+    int ok = 1;
+    for (int i = 0; i < thread_count && ok; i++) {
+        ImportChunk *chunk = &chunks[i];
+        skipped += chunk->skipped;
+        uint32_t *ids = malloc((chunk->category_count + 1) * sizeof(uint32_t));
+        ok = !chunk->out_of_memory && ids != NULL;
+        for (uint32_t c = 0; c < chunk->category_count && ok; c++) {
+            ids[c] = internCategory(chunk->text + chunk->category_names[c]);
+            ok = ids[c] != NO_CATEGORY;
+        }
+        for (long long r = 0; r < chunk->count && ok; r++) {
+            const char *description = chunk->text + chunk->descriptions[r];
+            ok = appendRow(chunk->amounts[r], chunk->is_expense[r], chunk->times[r],
+                           ids[chunk->categories[r]], description, strlen(description));
+            imported += ok;
+        }
+        free(ids);
+    }
+    for (int i = 0; i < thread_count; i++) {
+        freeImportChunk(&chunks[i]);
+    }
+    unmapFile(&file);
+
+    if (!ok) {
+        printf("Error: Not enough memory; only the first %lld transactions were imported.\n", imported);
+    }
+    printf("Imported %lld transactions from %s in %.3f seconds (parsed on %d threads in %.3f).\n",
+           imported, path, nowSeconds() - start, thread_count, parsed - start);
+    if (skipped > 0) {
+        printf("Skipped %lld lines that could not be read.\n", skipped);
+    }
+    // One checkpoint for the whole batch rather than a log record each. If it
+    // fails the batch goes to the log after all, so it survives a crash and
+    // later transactions are logged in sequence behind it.
+    if (imported > 0 && !saveDataToFile() && !logRows(first_row)) {
+        printf("Error: Could not write the imported transactions to %s either; they will be saved on exit.\n",
+               LOG_FILENAME);
+        if (log_file != NULL) {
+            fclose(log_file); // A gap in the log would stop replay at the next transaction
+            log_file = NULL;
+        }
+        ok = 0;
+    }
+    return ok;
+}
 
-    double total_income = 0.0;
-    double total_expense = 0.0;
+// Parser thread body: reads every line of one chunk of a statement
+THREAD_RETURN importWorker(void *arg) {
+    ImportChunk *chunk = (ImportChunk *)arg;
+    const ImportLayout *layout = chunk->layout;
+    const unsigned char *p = chunk->begin;
+    char scratch[IMPORT_MAX_LINE];
+    const char *fields[IMPORT_MAX_FIELDS];
+    size_t lengths[IMPORT_MAX_FIELDS];
 
-    for (int i = 0; i < transaction_count; i++) {
-        if (transactions[i].type == INCOME) {
-            total_income += transactions[i].amount;
+    while (p < chunk->end && !chunk->out_of_memory) {
+        const unsigned char *line = p;
+        const unsigned char *nl = memchr(p, '\n', (size_t)(chunk->end - p));
+        const unsigned char *line_end = nl ? nl : chunk->end;
+        p = nl ? nl + 1 : chunk->end;
+        while (line_end > line && (line_end[-1] == '\r' || line_end[-1] == ' ')) line_end--;
+        if (line == line_end) {
+            continue;
+        }
+        int count = line_end - line < IMPORT_MAX_LINE
+                  ? splitCsvLine((const char *)line, (size_t)(line_end - line), scratch, fields, lengths) : -1;
+
+        // The date and an amount are required; everything else has a default
+        int64_t when, cents;
+        int is_expense;
+        if (count <= layout->date || !parseStatementDate(chunk, fields[layout->date], lengths[layout->date], &when)) {
+            chunk->skipped++;
+            continue;
+        }
+        if (layout->amount >= 0) {
+            if (count <= layout->amount || !parseCents(fields[layout->amount], lengths[layout->amount], &cents)) {
+                chunk->skipped++;
+                continue;
+            }
+            is_expense = cents < 0;
+            if (layout->type >= 0 && count > layout->type) {
+                int direction = typeDirection(fields[layout->type], lengths[layout->type]);
+                is_expense = direction >= 0 ? direction : is_expense;
+            }
+        } else if (count > layout->debit && lengths[layout->debit] > 0) {
+            if (!parseCents(fields[layout->debit], lengths[layout->debit], &cents)) {
+                chunk->skipped++;
+                continue;
+            }
+            is_expense = 1;
+        } else if (count > layout->credit && parseCents(fields[layout->credit], lengths[layout->credit], &cents)) {
+            is_expense = 0;
         } else {
-            total_expense += transactions[i].amount;
+            chunk->skipped++;
+            continue;
+        }
+        cents = cents < 0 ? -cents : cents;
+
+        const char *category = DEFAULT_CATEGORY;
+        size_t category_length = strlen(DEFAULT_CATEGORY);
+        if (layout->category >= 0 && count > layout->category && lengths[layout->category] > 0) {
+            category = fields[layout->category];
+            category_length = lengths[layout->category];
+        }
+        const char *description = "";
+        size_t description_length = 0;
+        if (layout->description >= 0 && count > layout->description) {
+            description = fields[layout->description];
+            description_length = lengths[layout->description];
+        }
+        // Same limits as typed-in transactions
+        category_length = category_length < MAX_DESC_LENGTH ? category_length : MAX_DESC_LENGTH - 1;
+        description_length = description_length < MAX_DESC_LENGTH ? description_length : MAX_DESC_LENGTH - 1;
+        if (!storeImportedRow(chunk, cents, is_expense, when, category, category_length,
+                              description, description_length)) {
+            chunk->out_of_memory = 1;
         }
     }
+    return THREAD_RESULT;
+}
 
-    printf("--- Financial Summary ---\n");
-    printf("Total Income:   $%.2f\n", total_income);
-    printf("Total Expenses: $%.2f\n", total_expense);
-    printf("-------------------------\n");
-    printf("Net Balance:    $%.2f\n", total_income - total_expense);
-    printf("-------------------------\n");
+// Adds a parsed row to a chunk's results. Returns 0 if out of memory.
+int storeImportedRow(ImportChunk *chunk, int64_t cents, int is_expense, int64_t when,
+                     const char *category, size_t category_length,
+                     const char *description, size_t description_length) {
+    if (chunk->count == chunk->capacity) {
+        long long grown = chunk->capacity ? chunk->capacity * 2 : 1024;
+        int64_t *amounts = realloc(chunk->amounts, (size_t)grown * sizeof(int64_t));
+        if (amounts != NULL) chunk->amounts = amounts;
+        int64_t *times = realloc(chunk->times, (size_t)grown * sizeof(int64_t));
+        if (times != NULL) chunk->times = times;
+        unsigned char *flags = realloc(chunk->is_expense, (size_t)grown);
+        if (flags != NULL) chunk->is_expense = flags;
+        uint32_t *ids = realloc(chunk->categories, (size_t)grown * sizeof(uint32_t));
+        if (ids != NULL) chunk->categories = ids;
+        size_t *offsets = realloc(chunk->descriptions, (size_t)grown * sizeof(size_t));
+        if (offsets != NULL) chunk->descriptions = offsets;
+        if (amounts == NULL || times == NULL || flags == NULL || ids == NULL || offsets == NULL) {
+            return 0;
+        }
+        chunk->capacity = grown;
+    }
+    uint32_t id = internLocalCategory(chunk, category, category_length);
+    size_t offset = appendChunkText(chunk, description, description_length);
+    if (id == NO_CATEGORY || offset == SIZE_MAX) {
+        return 0;
+    }
+    long long r = chunk->count++;
+    chunk->amounts[r] = cents;
+    chunk->times[r] = when;
+    chunk->is_expense[r] = (unsigned char)is_expense;
+    chunk->categories[r] = id;
+    chunk->descriptions[r] = offset;
+    return 1;
 }
 
-// Saves all transaction data to a binary file
-void saveDataToFile() {
-    FILE *file = fopen(FILENAME, "wb"); // Open in binary write mode
-    if (file == NULL) {
-        printf("Error: Could not open file %s for writing.\n", FILENAME);
-        return;
+// Returns a chunk's local id for a category name, adding it if it is new.
+// Returns NO_CATEGORY if out of memory.
+uint32_t internLocalCategory(ImportChunk *chunk, const char *name, size_t length) {
+    unsigned int hash = checksumBytes(name, length);
+    if (chunk->category_index_size > 0) {
+        uint32_t mask = chunk->category_index_size - 1;
+        for (uint32_t slot = hash & mask; chunk->category_index[slot] != 0; slot = (slot + 1) & mask) {
+            const char *known = chunk->text + chunk->category_names[chunk->category_index[slot] - 1];
+            if (memcmp(known, name, length) == 0 && known[length] == 0) {
+                return chunk->category_index[slot] - 1;
+            }
+        }
     }
 
-    // Write the number of transactions first
-    fwrite(&transaction_count, sizeof(int), 1, file);
-    // Write the entire transactions array
-    fwrite(transactions, sizeof(Transaction), transaction_count, file);
+    if (chunk->category_count == chunk->category_capacity) {
+        uint32_t grown = chunk->category_capacity ? chunk->category_capacity * 2 : 32;
+        size_t *names = realloc(chunk->category_names, grown * sizeof(size_t));
+        if (names == NULL) {
+            return NO_CATEGORY;
+        }
+        chunk->category_names = names;
+        chunk->category_capacity = grown;
+    }
+    if ((chunk->category_count + 1) * 2 > chunk->category_index_size) {
+        uint32_t size = chunk->category_index_size ? chunk->category_index_size * 2 : 64;
+        uint32_t *index = calloc(size, sizeof(uint32_t));
+        if (index == NULL) {
+            return NO_CATEGORY;
+        }
+        for (uint32_t id = 0; id < chunk->category_count; id++) {
+            const char *known = chunk->text + chunk->category_names[id];
+            uint32_t slot = checksumBytes(known, strlen(known)) & (size - 1);
+            while (index[slot] != 0) {
+                slot = (slot + 1) & (size - 1);
+            }
+            index[slot] = id + 1;
+        }
+        free(chunk->category_index);
+        chunk->category_index = index;
+        chunk->category_index_size = size;
+    }
+    size_t offset = appendChunkText(chunk, name, length);
+    if (offset == SIZE_MAX) {
+        return NO_CATEGORY;
+    }
+    uint32_t slot = hash & (chunk->category_index_size - 1);
+    while (chunk->category_index[slot] != 0) {
+        slot = (slot + 1) & (chunk->category_index_size - 1);
+    }
+    chunk->category_index[slot] = chunk->category_count + 1;
+    chunk->category_names[chunk->category_count] = offset;
+    return chunk->category_count++;
+}
 
-    fclose(file);
+// Copies text (plus a NUL) to a chunk's text heap and returns its offset,
+// or SIZE_MAX if out of memory
+size_t appendChunkText(ImportChunk *chunk, const char *text, size_t length) {
+    if (chunk->text_size + length + 1 > chunk->text_capacity) {
+        size_t grown = chunk->text_capacity ? chunk->text_capacity * 2 : 64 * 1024;
+        while (grown < chunk->text_size + length + 1) {
+            grown *= 2;
+        }
+        char *heap = realloc(chunk->text, grown);
+        if (heap == NULL) {
+            return SIZE_MAX;
+        }
+        chunk->text = heap;
+        chunk->text_capacity = grown;
+    }
+    size_t offset = chunk->text_size;
+    memcpy(chunk->text + offset, text, length);
+    chunk->text[offset + length] = 0;
+    chunk->text_size += length + 1;
+    return offset;
 }
 
-// Loads transaction data from the binary file
-void loadDataFromFile() {
-    FILE *file = fopen(FILENAME, "rb"); // Open in binary read mode
-    if (file == NULL) {
-        // If the file doesn't exist, it's the first run. Do nothing.
+// Releases everything a parser thread allocated
+void freeImportChunk(ImportChunk *chunk) {
+    free(chunk->amounts);
+    free(chunk->times);
+    free(chunk->is_expense);
+    free(chunk->categories);
+    free(chunk->descriptions);
+    free(chunk->text);
+    free(chunk->category_names);
+    free(chunk->category_index);
+}
+
+// Splits one CSV line into fields, unquoting "..." fields ("" is a literal
+// quote) into `scratch`, which must be at least as long as the line. Spaces
+// around unquoted fields are trimmed. Returns the number of fields, or -1 if
+// there are more than IMPORT_MAX_FIELDS.
+int splitCsvLine(const char *line, size_t length, char *scratch, const char **fields, size_t *lengths) {
+    int count = 0;
+    size_t i = 0, out = 0;
+    for (;;) {
+        if (count == IMPORT_MAX_FIELDS) {
+            return -1;
+        }
+        while (i < length && line[i] == ' ') i++;
+        size_t start = out;
+        if (i < length && line[i] == '"') {
+            for (i++; i < length; i++) {
+                if (line[i] == '"') {
+                    if (i + 1 < length && line[i + 1] == '"') {
+                        i++;
+                    } else {
+                        i++;
+                        break;
+                    }
+                }
+                scratch[out++] = line[i];
+            }
+            while (i < length && line[i] != ',') i++; // Ignore anything after the closing quote
+        } else {
+            while (i < length && line[i] != ',') {
+                scratch[out++] = line[i++];
+            }
+            while (out > start && scratch[out - 1] == ' ') out--;
+        }
+        fields[count] = scratch + start;
+        lengths[count++] = out - start;
+        if (i >= length) {
+            return count;
+        }
+        i++; // Skip the comma
+    }
+}
+
+// Recognises a header line by its column names and fills in the layout.
+// Returns 0 (leaving the layout alone) if the line does not look like a header.
+int readImportLayout(const char **fields, const size_t *lengths, int count, ImportLayout *layout) {
+    ImportLayout found = { -1, -1, -1, -1, -1, -1, -1 };
+    for (int i = 0; i < count; i++) {
+        const char *f = fields[i];
+        size_t n = lengths[i];
+        if (found.date < 0 && fieldContains(f, n, "date")) {
+            found.date = i;
+        } else if (found.debit < 0 && (fieldContains(f, n, "debit") || fieldContains(f, n, "withdraw") ||
+                                        fieldContains(f, n, "money out"))) {
+            found.debit = i; // Before "amount", which "Debit Amount" also contains
+        } else if (found.credit < 0 && (fieldContains(f, n, "credit") || fieldContains(f, n, "deposit") ||
+                                         fieldContains(f, n, "money in"))) {
+            found.credit = i;
+        } else if (found.amount < 0 && fieldContains(f, n, "amount")) {
+            found.amount = i;
+        } else if (found.type < 0 && fieldContains(f, n, "type")) {
+            found.type = i;
+        } else if (found.category < 0 && fieldContains(f, n, "category")) {
+            found.category = i;
+        } else if (found.description < 0 && (fieldContains(f, n, "description") || fieldContains(f, n, "memo") ||
+                                              fieldContains(f, n, "payee") || fieldContains(f, n, "details") ||
+                                              fieldContains(f, n, "narrative") || fieldContains(f, n, "name"))) {
+            found.description = i;
+        }
+    }
+    if (found.debit >= 0 && found.credit >= 0) {
+        found.amount = -1; // A plain amount column is only used without the pair
+    }
+    if (found.date < 0 || (found.amount < 0 && (found.debit < 0 || found.credit < 0))) {
+        return 0;
+    }
+    *layout = found;
+    return 1;
+}
+
+// Whether a field contains a lowercase ASCII word, ignoring case
+int fieldContains(const char *field, size_t length, const char *word) {
+    size_t word_length = strlen(word);
+    for (size_t i = 0; i + word_length <= length; i++) {
+        size_t k = 0;
+        while (k < word_length && (field[i + k] | 0x20) == word[k]) k++;
+        if (k == word_length) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Reads a transaction type column: 1 if it names a debit, 0 if it names a
+// credit, -1 if it is neither (e.g. "POS" or "CHECK_PAID"), in which case the
+// amount's sign decides
+int typeDirection(const char *type, size_t length) {
+    if (fieldContains(type, length, "debit") || fieldContains(type, length, "expense") ||
+        fieldContains(type, length, "withdraw") || (length == 2 && fieldContains(type, 2, "dr"))) {
+        return 1;
+    }
+    if (fieldContains(type, length, "credit") || fieldContains(type, length, "deposit") ||
+        fieldContains(type, length, "income") || (length == 2 && fieldContains(type, 2, "cr"))) {
+        return 0;
+    }
+    return -1;
+}
+
+// Parses a money amount into cents: an optional sign or parentheses for a
+// negative, an optional '$', digits with optional ',' separators, and up to
+// two decimals (a third is rounded half up, any further ones are ignored).
+// Returns 0 if the text is not an amount or is too large.
+int parseCents(const char *text, size_t length, int64_t *cents) {
+    size_t i = 0;
+    int negative = 0;
+    while (length > 0 && text[length - 1] == ' ') length--;
+    while (i < length && text[i] == ' ') i++;
+    if (i < length && text[i] == '(' && text[length - 1] == ')') {
+        negative = 1;
+        i++;
+        length--;
+    }
+    if (i < length && (text[i] == '-' || text[i] == '+')) {
+        negative ^= text[i] == '-';
+        i++;
+    }
+    if (i < length && text[i] == '$') {
+        i++;
+    }
+
+    uint64_t value = 0;
+    int digits = 0;
+    for (; i < length && ((unsigned char)(text[i] - '0') < 10 || (text[i] == ',' && digits > 0)); i++) {
+        if (text[i] == ',') {
+            continue;
+        }
+        if (value > (uint64_t)INT64_MAX / 1000) {
+            return 0; // Leaves room for the cents and the rounding
+        }
+        value = value * 10 + (uint64_t)(text[i] - '0');
+        digits++;
+    }
+    value *= 100;
+    if (i < length && text[i] == '.') {
+        for (int place = 0, scale = 10; ++i < length && (unsigned char)(text[i] - '0') < 10; place++) {
+            if (place < 2) {
+                value += (uint64_t)(text[i] - '0') * (uint64_t)scale;
+                scale /= 10;
+            } else if (place == 2 && text[i] >= '5') {
+                value++;
+            }
+            digits++;
+        }
+    }
+    if (i != length || digits == 0) {
+        return 0;
+    }
+    *cents = negative ? -(int64_t)value : (int64_t)value;
+    return 1;
+}
+
+// Parses YYYY-MM-DD (or YYYY/MM/DD), optionally followed by HH:MM[:SS], as a
+// local time. The local midnight of the last date is cached per chunk, so
+// mktime() only runs when the date changes, except on days with a DST
+// change, whose times cannot be found by adding to midnight.
+int parseStatementDate(ImportChunk *chunk, const char *text, size_t length, int64_t *when) {
+    int parts[6] = {0, 0, 0, 0, 0, 0};
+    int part = 0, digits = 0;
+    for (size_t i = 0; i < length && part < 6; i++) {
+        char c = text[i];
+        if ((unsigned char)(c - '0') < 10 && digits < 4) {
+            parts[part] = parts[part] * 10 + (c - '0');
+            digits++;
+        } else if (digits > 0 && ((part < 2 && (c == '-' || c == '/')) || (part == 2 && (c == ' ' || c == 'T')) ||
+                                  (part >= 3 && c == ':'))) {
+            part++;
+            digits = 0;
+        } else {
+            return 0;
+        }
+    }
+    if (part < 2 || part == 3 || digits == 0 || parts[3] > 23 || parts[4] > 59 || parts[5] > 60) {
+        return 0;
+    }
+    // cached_year stays 0 until a date has been validated
+    if (chunk->cached_year == 0 || parts[0] != chunk->cached_year || parts[1] != chunk->cached_month ||
+        parts[2] != chunk->cached_day) {
+        if (!localMidnight(parts[0], parts[1], parts[2], &chunk->cached_midnight)) {
+            return 0;
+        }
+        struct tm next;
+        memset(&next, 0, sizeof(next));
+        next.tm_year = parts[0] - 1900;
+        next.tm_mon = parts[1] - 1;
+        next.tm_mday = parts[2] + 1;
+        next.tm_isdst = -1;
+        chunk->cached_whole_day = mktime(&next) - chunk->cached_midnight == 86400;
+        chunk->cached_year = parts[0];
+        chunk->cached_month = parts[1];
+        chunk->cached_day = parts[2];
+    }
+    if (chunk->cached_whole_day) {
+        *when = (int64_t)chunk->cached_midnight + parts[3] * 3600 + parts[4] * 60 + parts[5];
+        return 1;
+    }
+    struct tm date;
+    memset(&date, 0, sizeof(date));
+    date.tm_year = parts[0] - 1900;
+    date.tm_mon = parts[1] - 1;
+    date.tm_mday = parts[2];
+    date.tm_hour = parts[3];
+    date.tm_min = parts[4];
+    date.tm_sec = parts[5];
+    date.tm_isdst = -1;
+    time_t exact = mktime(&date);
+    if (exact == (time_t)-1) {
+        return 0;
+    }
+    *when = (int64_t)exact;
+    return 1;
+}
+
+// Starts a report into the shared buffer
+void startReport(ReportWriter *writer, FILE *out) {
+    writer->out = out;
+    writer->buffer = report_buffer;
+    writer->used = 0;
+    writer->failed = 0;
+}
+
+// Column names and rule of the transaction table
+void renderTableHeader(ReportWriter *writer) {
+    static const char header[] =
+        "ID    | Date             | Type         | Amount          | Category             | Description              \n";
+    renderText(writer, header, sizeof(header) - 1, 0);
+    renderTableRule(writer);
+}
+
+// Horizontal rule as wide as the transaction table
+void renderTableRule(ReportWriter *writer) {
+    static const char rule[] =
+        "------------------------------------------------------------------------------------------------------------\n";
+    renderText(writer, rule, sizeof(rule) - 1, 0);
+}
+
+// Renders one row of a block as a table line
+void renderTransactionRow(ReportWriter *writer, const TransactionBlock *block, long long row) {
+    if (writer->used + REPORT_ROW_MAX > REPORT_BUFFER_SIZE) {
+        flushReport(writer);
+    }
+    char field[32];
+    int is_expense = (int)(block->expense_bits[row / 64] >> (row % 64) & 1);
+    const char *category = category_names[block->category_ids[row]];
+    const char *description = rowDescription(block, row);
+
+    renderText(writer, field, formatInteger(block->first_row + row + 1, field), 5);
+    renderText(writer, " | ", 3, 0);
+    renderText(writer, field, formatLocalTime(block->times[row], field), 16);
+    renderText(writer, " | ", 3, 0);
+    renderText(writer, is_expense ? "Expense" : "Income", is_expense ? 7 : 6, 12);
+    renderText(writer, " | $", 4, 0);
+    renderText(writer, field, formatCents(block->amounts[row], field), 14);
+    renderText(writer, " | ", 3, 0);
+    renderText(writer, category, strlen(category), 20);
+    renderText(writer, " | ", 3, 0);
+    renderText(writer, description, strlen(description), 25);
+    writer->buffer[writer->used++] = '\n';
+}
+
+// Appends text, padded with spaces to `width` like printf("%-*s")
+void renderText(ReportWriter *writer, const char *text, size_t length, size_t width) {
+    if (writer->used + length + width > REPORT_BUFFER_SIZE) {
+        flushReport(writer);
+        if (length > REPORT_BUFFER_SIZE - width) {
+            return;
+        }
+    }
+    memcpy(writer->buffer + writer->used, text, length);
+    writer->used += length;
+    for (; length < width; length++) {
+        writer->buffer[writer->used++] = ' ';
+    }
+}
+
+// Writes out everything buffered. Returns 0 if any write of this report failed.
+int flushReport(ReportWriter *writer) {
+    if (writer->used > 0 && fwrite(writer->buffer, 1, writer->used, writer->out) != writer->used) {
+        writer->failed = 1;
+    }
+    writer->used = 0;
+    return !writer->failed;
+}
+
+// Formats a timestamp as local "YYYY-MM-DD HH:MM" and returns its length.
+// The date text is cached and only formatted again when the day changes. A
+// timestamp the C library cannot represent (from a damaged ledger) is shown
+// as "invalid time".
+size_t formatLocalTime(int64_t when, char *out) {
+    static LocalTime text_date = {0, 0, 0, 0};
+    static char day_text[40];
+    static size_t day_length = 0;
+    LocalTime parts;
+    if (!localTimeParts((time_t)when, &parts)) {
+        memcpy(out, "invalid time", 12);
+        return 12;
+    }
+    if (parts.year != text_date.year || parts.month != text_date.month || parts.day != text_date.day) {
+        day_length = (size_t)snprintf(day_text, sizeof(day_text), "%04lld-%02d-%02d", parts.year, parts.month,
+                                      parts.day);
+        text_date = parts;
+    }
+    int minutes = parts.minute;
+    memcpy(out, day_text, day_length);
+    out += day_length;
+    out[0] = ' ';
+    out[1] = (char)('0' + minutes / 600);
+    out[2] = (char)('0' + minutes / 60 % 10);
+    out[3] = ':';
+    out[4] = (char)('0' + minutes % 60 / 10);
+    out[5] = (char)('0' + minutes % 10);
+    return day_length + 6;
+}
+
+// Formats cents as a fixed-point decimal ("-1234.05") and returns its length
+size_t formatCents(int64_t cents, char *out) {
+    char digits[24];
+    int n = 0;
+    uint64_t value = cents < 0 ? 0 - (uint64_t)cents : (uint64_t)cents;
+    digits[n++] = (char)('0' + value % 10);
+    value /= 10;
+    digits[n++] = (char)('0' + value % 10);
+    value /= 10;
+    digits[n++] = '.';
+    do {
+        digits[n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+
+    size_t length = 0;
+    if (cents < 0) {
+        out[length++] = '-';
+    }
+    while (n > 0) {
+        out[length++] = digits[--n];
+    }
+    return length;
+}
+
+// Formats cents like formatCents() into a NUL-terminated buffer of at least
+// 32 bytes and returns it, for use in printf arguments
+const char *centsText(int64_t cents, char *out) {
+    out[formatCents(cents, out)] = 0;
+    return out;
+}
+
+// Formats a non-negative integer in decimal and returns its length
+size_t formatInteger(long long value, char *out) {
+    char digits[24];
+    int n = 0;
+    do {
+        digits[n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    size_t length = 0;
+    while (n > 0) {
+        out[length++] = digits[--n];
+    }
+    return length;
+}
+
+// Lists and totals the transactions between two dates (inclusive), in time
+// order. Both ends are found by binary search over the time order, so the
+// cost depends on how many transactions match, not on the ledger size.
+void viewDateRange() {
+    time_t first_day, last_day;
+    if (!readDate("Enter start date (YYYY-MM-DD): ", &first_day) ||
+        !readDate("Enter end date (YYYY-MM-DD): ", &last_day)) {
+        return;
+    }
+    struct tm end = *localtime(&last_day);
+    end.tm_mday++;
+    end.tm_isdst = -1;
+    time_t after = mktime(&end); // Midnight after the end date
+    if (!ensureTimeOrder()) {
+        printf("Error: Not enough memory to sort the transactions by date.\n");
         return;
     }
 
-    // Read the number of transactions
-    fread(&transaction_count, sizeof(int), 1, file);
-    // Read the transaction data into the array
-    fread(transactions, sizeof(Transaction), transaction_count, file);
+    long long from = lowerBoundTime((int64_t)first_day);
+    long long to = after > first_day ? lowerBoundTime((int64_t)after) : from;
+    if (from == to) {
+        printf("No transactions in that date range.\n");
+        return;
+    }
+    printf("--- Transactions in Range ---\n");
+    ReportWriter writer;
+    startReport(&writer, stdout);
+    renderTableHeader(&writer);
+    for (long long position = from; position < to; position++) {
+        long long r;
+        const TransactionBlock *block = locateRow(orderedRow(position), &r);
+        renderTransactionRow(&writer, block, r);
+    }
+    renderTableRule(&writer);
+    flushReport(&writer);
 
-    fclose(file);
-    printf("Data loaded successfully from %s.\n", FILENAME);
-    printf("Press Enter to continue...");
-    getchar();
+    SummaryTotals totals;
+    char income[32], expense[32], net[32];
+    summarizeOrderedRange(from, to, &totals);
+    printf("Transactions: %lld   Income: $%s   Expenses: $%s   Net: $%s\n", totals.count,
+           centsText(totals.income, income), centsText(totals.expense, expense), centsText(totals.net, net));
 }
 
-// Utility function to clear the input buffer
-void clearInputBuffer() {
-    int c;
-    while ((c = getchar()) != '\n' && c != EOF);
+// Totals positions [from, to) of the time order. While that order is the
+// identity the range is contiguous in every block, so the column kernels run
+// on it directly; otherwise rows are gathered one by one.
+void summarizeOrderedRange(long long from, long long to, SummaryTotals *totals) {
+    totals->income = 0;
+    totals->expense = 0;
+    totals->count = 0;
+    totals->min = INT64_MAX;
+    totals->max = INT64_MIN;
+    for (long long position = from; position < to; ) {
+        long long r;
+        const TransactionBlock *block = locateRow(orderedRow(position), &r);
+        long long n = 1;
+        if (time_order_identity) {
+            n = block->count - r < to - position ? block->count - r : to - position;
+        }
+        if (useAVX2()) {
+            summarizeRowsAVX2(block, r, r + n, totals);
+        } else {
+            summarizeRows(block, r, r + n, totals);
+        }
+        position += n;
+    }
+    totals->net = totals->income - totals->expense;
+}
+
+// Prompts for a date as YYYY-MM-DD and returns its local midnight.
+// Returns 0 (after saying why) if it is invalid.
+int readDate(const char *prompt, time_t *midnight) {
+    int year, month, day;
+    printf("%s", prompt);
+    if (scanf("%d-%d-%d", &year, &month, &day) != 3 || !localMidnight(year, month, day, midnight)) {
+        clearInputBuffer();
+        printf("Invalid date. Use the format YYYY-MM-DD.\n");
+        return 0;
+    }
+    clearInputBuffer();
+    return 1;
+}
+
+// Records the time of the newest row. The time order stays the identity for
+// as long as every row is at least as late as the one before it.
+void noteRowTime(int64_t when) {
+    if (when < last_row_time) {
+        time_order_identity = 0;
+    }
+    last_row_time = when;
 }
 
+// Brings the explicit time order up to date with rows added since it was last
+// used: the new rows are sorted on their own and merged in. Nothing to do
+// while the order is the identity. Returns 0 if out of memory.
+int ensureTimeOrder() {
+    if (time_order_identity || time_order_rows == transaction_count) {
+        return 1;
+    }
+    long long added = transaction_count - time_order_rows;
+    TimeKey *keys = malloc((size_t)added * sizeof(TimeKey));
+    long long *order = malloc((size_t)transaction_count * sizeof(long long));
+    if (keys == NULL || order == NULL) {
+        free(keys);
+        free(order);
+        return 0;
+    }
+    for (long long i = 0; i < added; i++) {
+        keys[i].row = time_order_rows + i;
+        keys[i].time = rowTime(keys[i].row);
+    }
+    qsort(keys, (size_t)added, sizeof(TimeKey), compareTimeKeys);
+
+    // Merge; on equal times the older row (always in time_order) goes first
+    long long i = 0, j = 0, k = 0;
+    int64_t old_time = time_order_rows > 0 ? rowTime(time_order[0]) : 0;
+    while (i < time_order_rows && j < added) {
+        if (old_time <= keys[j].time) {
+            order[k++] = time_order[i++];
+            if (i < time_order_rows) {
+                old_time = rowTime(time_order[i]);
+            }
+        } else {
+            order[k++] = keys[j++].row;
+        }
+    }
+    while (i < time_order_rows) {
+        order[k++] = time_order[i++];
+    }
+    while (j < added) {
+        order[k++] = keys[j++].row;
+    }
+    free(keys);
+    free(time_order);
+    time_order = order;
+    time_order_rows = transaction_count;
+    return 1;
+}
+
+// First position in the time order whose row is at or after `when`
+long long lowerBoundTime(int64_t when) {
+    long long lo = 0, hi = transaction_count;
+    while (lo < hi) {
+        long long mid = lo + (hi - lo) / 2;
+        if (rowTime(orderedRow(mid)) < when) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Ledger row at a position of the time order (see ensureTimeOrder())
+long long orderedRow(long long position) {
+    return time_order_identity ? position : time_order[position];
+}
+
+// transaction_time of ledger row `index`
+int64_t rowTime(long long index) {
+    long long r;
+    const TransactionBlock *block = locateRow(index, &r);
+    return block->times[r];
+}
+
+// qsort() comparator: by time, then by row so equal times keep ledger order
+int compareTimeKeys(const void *a, const void *b) {
+    const TimeKey *x = (const TimeKey *)a;
+    const TimeKey *y = (const TimeKey *)b;
+    if (x->time != y->time) {
+        return x->time < y->time ? -1 : 1;
+    }
+    return x->row < y->row ? -1 : (x->row > y->row);
+}
+
+// Calculates and displays the financial summary
+void displaySummary() {
+    if (transaction_count == 0) {
+        printf("No data for summary. Please add a transaction first.\n");
+        return;
+    }
+
+    SummaryTotals totals;
+    char text[32];
+    summarizeTransactions(&totals);
+
+    printf("--- Financial Summary ---\n");
+    printf("Total Income:   $%s\n", centsText(totals.income, text));
+    printf("Total Expenses: $%s\n", centsText(totals.expense, text));
+    printf("-------------------------\n");
+    printf("Net Balance:    $%s\n", centsText(totals.net, text));
+    printf("-------------------------\n");
+    printf("Transactions:   %lld\n", totals.count);
+    printf("Smallest:       $%s\n", centsText(totals.min, text));
+    printf("Largest:        $%s\n", centsText(totals.max, text));
+}
+
+// Totals every transaction, one block at a time with the fastest kernel the CPU supports
+void summarizeTransactions(SummaryTotals *totals) {
+    totals->income = 0;
+    totals->expense = 0;
+    totals->count = 0;
+    totals->min = INT64_MAX;
+    totals->max = INT64_MIN;
+    for (int b = 0; b < block_count; b++) {
+        if (useAVX2()) {
+            summarizeRowsAVX2(&blocks[b], 0, blocks[b].count, totals);
+        } else {
+            summarizeRows(&blocks[b], 0, blocks[b].count, totals);
+        }
+    }
+    totals->net = totals->income - totals->expense;
+}
+
+// Adds rows [from, to) of a block to the totals. The expense bit is turned
+// into an all-ones or all-zero mask instead of being branched on, so the
+// mixed income/expense pattern of real ledgers costs no mispredictions.
+void summarizeRows(const TransactionBlock *block, long long from, long long to, SummaryTotals *totals) {
+    int64_t income = 0, expense = 0;
+    int64_t low = totals->min, high = totals->max;
+    for (long long r = from; r < to; r++) {
+        int64_t amount = block->amounts[r];
+        int64_t is_expense = -(int64_t)(block->expense_bits[r / 64] >> (r % 64) & 1);
+        expense += amount & is_expense;
+        income += amount & ~is_expense;
+        low = amount < low ? amount : low;
+        high = amount > high ? amount : high;
+    }
+    totals->income += income;
+    totals->expense += expense;
+    totals->count += to - from;
+    totals->min = low;
+    totals->max = high;
+}
+
+#ifdef HAVE_AVX2_KERNEL
+// AVX2 version of summarizeRows(): four rows per step, with the four
+// expense bits expanded into lane masks by comparing against 1, 2, 4, 8.
+// AVX2 has no 64-bit min/max, so those are a compare and a blend.
+__attribute__((target("avx2")))
+void summarizeRowsAVX2(const TransactionBlock *block, long long from, long long to, SummaryTotals *totals) {
+    // Scalar up to a multiple of 4 so every step's bits come from one bitmap word
+    long long start = (from + 3) / 4 * 4 < to ? (from + 3) / 4 * 4 : to;
+    summarizeRows(block, from, start, totals);
+    long long end = start + (to - start) / 4 * 4;
+
+    const __m256i select = _mm256_set_epi64x(8, 4, 2, 1);
+    __m256i income = _mm256_setzero_si256();
+    __m256i expense = _mm256_setzero_si256();
+    __m256i low = _mm256_set1_epi64x(totals->min);
+    __m256i high = _mm256_set1_epi64x(totals->max);
+    for (long long r = start; r < end; r += 4) {
+        __m256i amounts = _mm256_loadu_si256((const __m256i *)(block->amounts + r));
+        long long nibble = (long long)(block->expense_bits[r / 64] >> (r % 64) & 0xF);
+        __m256i is_expense = _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_set1_epi64x(nibble), select), select);
+        expense = _mm256_add_epi64(expense, _mm256_and_si256(is_expense, amounts));
+        income = _mm256_add_epi64(income, _mm256_andnot_si256(is_expense, amounts));
+        low = _mm256_blendv_epi8(low, amounts, _mm256_cmpgt_epi64(low, amounts));
+        high = _mm256_blendv_epi8(high, amounts, _mm256_cmpgt_epi64(amounts, high));
+    }
+
+    int64_t lanes[4][4];
+    _mm256_storeu_si256((__m256i *)lanes[0], income);
+    _mm256_storeu_si256((__m256i *)lanes[1], expense);
+    _mm256_storeu_si256((__m256i *)lanes[2], low);
+    _mm256_storeu_si256((__m256i *)lanes[3], high);
+    for (int i = 0; i < 4; i++) {
+        totals->income += lanes[0][i];
+        totals->expense += lanes[1][i];
+        totals->min = lanes[2][i] < totals->min ? lanes[2][i] : totals->min;
+        totals->max = lanes[3][i] > totals->max ? lanes[3][i] : totals->max;
+    }
+    totals->count += end - start;
+    summarizeRows(block, end, to, totals);
+}
+
+// Whether this CPU can run summarizeRowsAVX2(); checked once
+int useAVX2() {
+    static int supported = -1;
+    if (supported < 0) {
+        __builtin_cpu_init();
+        supported = __builtin_cpu_supports("avx2") ? 1 : 0;
+    }
+    return supported;
+}
+#else
+void summarizeRowsAVX2(const TransactionBlock *block, long long from, long long to, SummaryTotals *totals) {
+    summarizeRows(block, from, to, totals);
+}
+
+int useAVX2() {
+    return 0;
+}
+#endif
+
+// --bench: times the summary over synthetic rows three ways (the original
+// branchy loop over Transaction structs, the scalar column kernel and the
+// AVX2 kernel) and checks that they agree. The ledger files are not touched.
+int runBenchmark(long long rows) {
+    if (rows < 1) {
+        printf("Error: ROWS must be positive.\n");
+        return 1;
+    }
+    Transaction *records = calloc((size_t)rows, sizeof(Transaction));
+    TransactionBlock block;
+    memset(&block, 0, sizeof(block));
+    block.count = rows;
+    block.amounts = malloc((size_t)rows * sizeof(int64_t));
+    block.expense_bits = calloc((size_t)(rows + 63) / 64, sizeof(uint64_t));
+    if (records == NULL || block.amounts == NULL || block.expense_bits == NULL) {
+        printf("Error: Not enough memory for %lld rows.\n", rows);
+        free(records);
+        free(block.amounts);
+        free(block.expense_bits);
+        return 1;
+    }
+
+    // Amounts up to $10,000 with about 40% expenses in no particular order
+    uint64_t seed = 88172645463325252ull;
+    for (long long i = 0; i < rows; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        block.amounts[i] = (int64_t)(seed % 1000000) + 1;
+        records[i].amount = block.amounts[i];
+        records[i].type = (seed >> 32) % 10 < 4 ? EXPENSE : INCOME;
+        if (records[i].type == EXPENSE) {
+            block.expense_bits[i / 64] |= (uint64_t)1 << (i % 64);
+        }
+    }
+
+    printf("Summarizing %lld transactions, %d passes each:\n", rows, BENCH_PASSES);
+    int64_t total_income = 0, total_expense = 0;
+    char text[3][32];
+    double start = nowSeconds();
+    for (int pass = 0; pass < BENCH_PASSES; pass++) {
+        total_income = 0;
+        total_expense = 0;
+        for (long long i = 0; i < rows; i++) {
+            if (records[i].type == INCOME) {
+                total_income += records[i].amount;
+            } else {
+                total_expense += records[i].amount;
+            }
+        }
+    }
+    double elapsed = nowSeconds() - start;
+    double baseline = (double)rows * BENCH_PASSES / elapsed;
+    printf("  %-22s %8.1f M rows/s  (net $%s)\n", "Row loop:", baseline / 1e6,
+           centsText(total_income - total_expense, text[0]));
+
+    int ok = 1;
+    for (int kernel = 0; kernel < 2; kernel++) {
+        if (kernel == 1 && !useAVX2()) {
+            printf("  %-22s not supported on this CPU\n", "AVX2 columns:");
+            break;
+        }
+        SummaryTotals totals;
+        start = nowSeconds();
+        for (int pass = 0; pass < BENCH_PASSES; pass++) {
+            totals.income = totals.expense = 0;
+            totals.count = 0;
+            totals.min = INT64_MAX;
+            totals.max = INT64_MIN;
+            if (kernel == 0) {
+                summarizeRows(&block, 0, rows, &totals);
+            } else {
+                summarizeRowsAVX2(&block, 0, rows, &totals);
+            }
+        }
+        elapsed = nowSeconds() - start;
+        totals.net = totals.income - totals.expense;
+        printf("  %-22s %8.1f M rows/s  (net $%s, min $%s, max $%s)  %.1fx\n",
+               kernel == 0 ? "Scalar columns:" : "AVX2 columns:",
+               (double)rows * BENCH_PASSES / elapsed / 1e6, centsText(totals.net, text[0]),
+               centsText(totals.min, text[1]), centsText(totals.max, text[2]),
+               (double)rows * BENCH_PASSES / elapsed / baseline);
+        // Integer sums are exact, so every kernel must match the row loop to the cent
+        ok = ok && totals.count == rows && totals.income == total_income && totals.expense == total_expense;
+    }
+
+    free(records);
+    free(block.amounts);
+    free(block.expense_bits);
+    if (!ok) {
+        printf("Error: The kernels disagree with the row loop.\n");
+        return 1;
+    }
+    return 0;
+}
+
+// Reports menu. Every report reads the rollups only, so it takes the same
+// time for a hundred transactions as for ten million.
+void showReports() {
+    int choice;
+    printf("--- Reports ---\n");
+    printf("1. Spending by Category for a Month\n");
+    printf("2. Monthly Net for Recent Months\n");
+    printf("3. Daily Totals for a Month\n");
+    printf("Enter your choice: ");
+    if (scanf("%d", &choice) != 1) {
+        choice = 0;
+    }
+    clearInputBuffer();
+
+    switch (choice) {
+        case 1:
+            reportCategoriesForMonth();
+            break;
+        case 2:
+            reportMonthlyNet();
+            break;
+        case 3:
+            reportDailyTotals();
+            break;
+        default:
+            printf("Invalid choice! Please select a valid option (1-3).\n");
+    }
+}
+
+// Income and expense per category for one month
+void reportCategoriesForMonth() {
+    long long month;
+    if (!readYearMonth(&month)) {
+        return;
+    }
+    printf("\n%-20s | %-14s | %-14s | %-14s | %s\n", "Category", "Income", "Expenses", "Net", "Count");
+    printf("--------------------------------------------------------------------------------\n");
+    RollupCell total = {0, 0, 0};
+    char income[32], expense[32], net[32];
+    for (uint32_t id = 0; id < category_count; id++) {
+        const RollupCell *cell = peekRollupCell(&category_months, (int)id, month);
+        if (cell == NULL || cell->count == 0) {
+            continue;
+        }
+        printf("%-20s | $%-13s | $%-13s | $%-13s | %lld\n", category_names[id], centsText(cell->income, income),
+               centsText(cell->expense, expense), centsText(cell->income - cell->expense, net), cell->count);
+        total.income += cell->income;
+        total.expense += cell->expense;
+        total.count += cell->count;
+    }
+    printf("--------------------------------------------------------------------------------\n");
+    printf("%-20s | $%-13s | $%-13s | $%-13s | %lld\n", "Total", centsText(total.income, income),
+           centsText(total.expense, expense), centsText(total.income - total.expense, net), total.count);
+}
+
+// Income, expense and net for each of the last N months, oldest first
+void reportMonthlyNet() {
+    int months;
+    printf("Number of months to show (e.g., 60 for five years): ");
+    if (scanf("%d", &months) != 1 || months < 1) {
+        clearInputBuffer();
+        printf("Invalid number of months.\n");
+        return;
+    }
+    clearInputBuffer();
+
+    long long current;
+    char income[32], expense[32], net[32];
+    localDayNumber(time(NULL), &current);
+    printf("\n%-8s | %-14s | %-14s | %-14s\n", "Month", "Income", "Expenses", "Net");
+    printf("-------------------------------------------------------------\n");
+    for (long long month = current - months + 1; month <= current; month++) {
+        const RollupCell *cell = peekRollupCell(&month_totals, 0, month);
+        RollupCell empty = {0, 0, 0};
+        if (cell == NULL) {
+            cell = &empty;
+        }
+        printf("%04lld-%02lld  | $%-13s | $%-13s | $%-13s\n", month / 12, month % 12 + 1, centsText(cell->income, income),
+               centsText(cell->expense, expense), centsText(cell->income - cell->expense, net));
+    }
+}
+
+// Totals for every day of one month that has transactions
+void reportDailyTotals() {
+    long long month;
+    if (!readYearMonth(&month)) {
+        return;
+    }
+    long long year = month / 12;
+    int month_of_year = (int)(month % 12) + 1;
+    long long first_day = daysFromCivil(year, month_of_year, 1);
+    long long next_month = daysFromCivil(month_of_year == 12 ? year + 1 : year, month_of_year % 12 + 1, 1);
+    char income[32], expense[32], net[32];
+
+    printf("\n%-10s | %-14s | %-14s | %-14s | %s\n", "Date", "Income", "Expenses", "Net", "Count");
+    printf("--------------------------------------------------------------------------\n");
+    for (long long day = first_day; day < next_month; day++) {
+        const RollupCell *cell = peekRollupCell(&day_totals, 0, day);
+        if (cell == NULL || cell->count == 0) {
+            continue;
+        }
+        printf("%04lld-%02d-%02lld | $%-13s | $%-13s | $%-13s | %lld\n", year, month_of_year,
+               day - first_day + 1, centsText(cell->income, income), centsText(cell->expense, expense),
+               centsText(cell->income - cell->expense, net), cell->count);
+    }
+}
+
+// Prompts for a month as YYYY-MM. Returns 0 (after saying why) if it is invalid.
+int readYearMonth(long long *month) {
+    int year, month_of_year;
+    printf("Enter month (YYYY-MM): ");
+    if (scanf("%d-%d", &year, &month_of_year) != 2 || year < 0 || month_of_year < 1 || month_of_year > 12) {
+        clearInputBuffer();
+        printf("Invalid month. Use the format YYYY-MM.\n");
+        return 0;
+    }
+    clearInputBuffer();
+    *month = (long long)year * 12 + month_of_year - 1;
+    return 1;
+}
+
+// Finds (creating them if needed) the day, month and category-month buckets
+// a transaction belongs to, so they can be updated once it is stored.
+// Returns 0 if out of memory.
+int findRollupCells(int64_t when, uint32_t category, RollupCell *cells[3]) {
+    long long month;
+    long long day = localDayNumber((time_t)when, &month);
+    cells[0] = rollupCell(&day_totals, 0, day);
+    cells[1] = rollupCell(&month_totals, 0, month);
+    cells[2] = rollupCell(&category_months, (int)category, month);
+    return cells[0] != NULL && cells[1] != NULL && cells[2] != NULL;
+}
+
+// Adds one transaction to the buckets found by findRollupCells()
+void addToRollups(RollupCell *cells[3], int64_t amount, int is_expense) {
+    for (int i = 0; i < 3; i++) {
+        if (is_expense) {
+            cells[i]->expense += amount;
+        } else {
+            cells[i]->income += amount;
+        }
+        cells[i]->count++;
+    }
+}
+
+// Adds every row of a block loaded from the ledger to the rollups and the
+// time order. Returns 0 if out of memory.
+int indexBlock(const TransactionBlock *block) {
+    for (long long r = 0; r < block->count; r++) {
+        RollupCell *cells[3];
+        if (!findRollupCells(block->times[r], block->category_ids[r], cells)) {
+            return 0;
+        }
+        addToRollups(cells, block->amounts[r], (int)(block->expense_bits[r / 64] >> (r % 64) & 1));
+        noteRowTime(block->times[r]);
+    }
+    return 1;
+}
+
+// Returns the bucket for `key` in `row`, first growing the table to cover it.
+// The range at least doubles each time, so a run of new days or months costs
+// amortised constant time. A key the table cannot reach within ROLLUP_MAX_SPAN
+// keys and ROLLUP_MAX_CELLS cells becomes an outlier. Returns NULL if out of
+// memory.
+RollupCell *rollupCell(RollupTable *table, int row, long long key) {
+    if (table->span > 0 && key >= table->first && key < table->first + table->span && row < table->rows) {
+        return &table->cells[(size_t)row * table->span + (key - table->first)];
+    }
+    RollupOutlier *outlier = findRollupOutlier(table, row, key);
+    if (outlier != NULL) {
+        return &outlier->cell;
+    }
+
+    long long first = table->first, end = table->first + table->span;
+    if (table->span == 0) {
+        first = key - 32;
+        end = key + 32;
+    } else if (key < first) {
+        first = key < end - 2 * table->span ? key - 32 : end - 2 * table->span;
+        first = first < end - ROLLUP_MAX_SPAN ? end - ROLLUP_MAX_SPAN : first;
+    } else if (key >= end) {
+        end = key >= first + 2 * table->span ? key + 32 : first + 2 * table->span;
+        end = end > first + ROLLUP_MAX_SPAN ? first + ROLLUP_MAX_SPAN : end;
+    }
+    long long span = end - first;
+    long long rows = row >= table->rows ? (row + 1 > table->rows * 2 ? row + 1 : table->rows * 2) : table->rows;
+    if (rows * span > ROLLUP_MAX_CELLS) {
+        rows = row >= table->rows ? row + 1 : table->rows;
+    }
+    if (key < first || key >= end || rows * span > ROLLUP_MAX_CELLS) {
+        return addRollupOutlier(table, row, key);
+    }
+
+    RollupCell *cells = calloc((size_t)rows * (size_t)span, sizeof(RollupCell));
+    if (cells == NULL) {
+        return NULL;
+    }
+    for (int r = 0; r < table->rows; r++) {
+        memcpy(cells + (size_t)r * span + (table->first - first), table->cells + (size_t)r * table->span,
+               (size_t)table->span * sizeof(RollupCell));
+    }
+    free(table->cells);
+    table->cells = cells;
+    table->rows = (int)rows;
+    table->first = first;
+    table->span = span;
+    return &table->cells[(size_t)row * table->span + (key - table->first)];
+}
+
+// Returns the bucket for `key` in `row`, or NULL if nothing was ever added there
+const RollupCell *peekRollupCell(const RollupTable *table, int row, long long key) {
+    if (key < table->first || key >= table->first + table->span || row >= table->rows) {
+        RollupOutlier *outlier = findRollupOutlier(table, row, key);
+        return outlier != NULL ? &outlier->cell : NULL;
+    }
+    return &table->cells[(size_t)row * table->span + (key - table->first)];
+}
+
+// Finds an outlier bucket, or returns NULL if there is none for that row and key
+RollupOutlier *findRollupOutlier(const RollupTable *table, int row, long long key) {
+    if (table->outlier_count == 0) {
+        return NULL;
+    }
+    unsigned int mask = (unsigned int)table->outlier_slots - 1;
+    for (unsigned int slot = outlierHash(row, key) & mask; table->outliers[slot].row >= 0; slot = (slot + 1) & mask) {
+        if (table->outliers[slot].key == key && table->outliers[slot].row == row) {
+            return &table->outliers[slot];
+        }
+    }
+    return NULL;
+}
+
+// Hash of an outlier bucket's row and key
+unsigned int outlierHash(int row, long long key) {
+    return (unsigned int)((unsigned long long)key * 0x9E3779B97F4A7C15ULL >> 32) ^ (unsigned int)row;
+}
+
+// Adds an empty outlier bucket (which must not exist yet), growing the
+// outlier table as needed. Returns NULL if out of memory.
+RollupCell *addRollupOutlier(RollupTable *table, int row, long long key) {
+    if ((table->outlier_count + 1) * 2 > table->outlier_slots) {
+        int slots = table->outlier_slots ? table->outlier_slots * 2 : 16;
+        RollupOutlier *grown = malloc((size_t)slots * sizeof(RollupOutlier));
+        if (grown == NULL) {
+            return NULL;
+        }
+        for (int i = 0; i < slots; i++) {
+            grown[i].row = -1;
+        }
+        RollupOutlier *old = table->outliers;
+        int old_slots = table->outlier_slots;
+        table->outliers = grown;
+        table->outlier_slots = slots;
+        table->outlier_count = 0;
+        for (int i = 0; i < old_slots; i++) {
+            if (old[i].row >= 0) {
+                *addRollupOutlier(table, old[i].row, old[i].key) = old[i].cell;
+            }
+        }
+        free(old);
+    }
+    unsigned int mask = (unsigned int)table->outlier_slots - 1;
+    unsigned int slot = outlierHash(row, key) & mask;
+    while (table->outliers[slot].row >= 0) {
+        slot = (slot + 1) & mask;
+    }
+    RollupOutlier *outlier = &table->outliers[slot];
+    outlier->key = key;
+    outlier->row = row;
+    memset(&outlier->cell, 0, sizeof(outlier->cell));
+    table->outlier_count++;
+    return &outlier->cell;
+}
+
+// Local calendar day (days since 1970-01-01) and month (year * 12 + month - 1)
+// of a timestamp. One the C library cannot represent (from a damaged ledger)
+// is counted on its UTC day.
+long long localDayNumber(time_t when, long long *month) {
+    LocalTime parts;
+    if (localTimeParts(when, &parts)) {
+        *month = parts.year * 12 + parts.month - 1;
+        return daysFromCivil(parts.year, parts.month, parts.day);
+    }
+    long long days = (long long)(when / 86400) - (when % 86400 < 0);
+    // Civil date from a day number, the inverse of daysFromCivil()
+    long long shifted = days + 719468;
+    long long era = (shifted >= 0 ? shifted : shifted - 146096) / 146097;
+    long long day_of_era = shifted - era * 146097;
+    long long year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    long long day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    long long shifted_month = (5 * day_of_year + 2) / 153;
+    int month_of_year = (int)(shifted_month < 10 ? shifted_month + 3 : shifted_month - 9);
+    *month = (year_of_era + era * 400 + (month_of_year <= 2)) * 12 + month_of_year - 1;
+    return days;
+}
+
+// Breaks a timestamp into its local date and time of day. Ledgers are mostly
+// in time order, so the bounds of the last day seen are cached and
+// localtime() only runs when the day changes. Days with a DST change are not
+// cached, since their hours cannot be found by subtraction. Returns 0 if the
+// C library cannot represent the time.
+int localTimeParts(time_t when, LocalTime *parts) {
+    static time_t day_start = 1, day_end = 0;
+    static LocalTime cached;
+    if (when >= day_start && when < day_end) {
+        *parts = cached;
+        parts->minute = (int)((when - day_start) / 60);
+        return 1;
+    }
+    struct tm local;
+#ifdef _WIN32
+    if (localtime_s(&local, &when) != 0) {
+        return 0;
+    }
+#else
+    if (localtime_r(&when, &local) == NULL) {
+        return 0;
+    }
+#endif
+    parts->year = local.tm_year + 1900LL;
+    parts->month = local.tm_mon + 1;
+    parts->day = local.tm_mday;
+    parts->minute = local.tm_hour * 60 + local.tm_min;
+    local.tm_hour = local.tm_min = local.tm_sec = 0;
+    local.tm_isdst = -1;
+    time_t start = mktime(&local);
+    local.tm_mday++;
+    local.tm_isdst = -1;
+    time_t end = mktime(&local);
+    if (start != (time_t)-1 && end - start == 86400 && start <= when && when < end) {
+        day_start = start;
+        day_end = end;
+        cached = *parts;
+    } else {
+        day_start = 1;
+        day_end = 0;
+    }
+    return 1;
+}
+
+// Days from 1970-01-01 to a proleptic Gregorian date
+long long daysFromCivil(long long year, int month, int day) {
+    year -= month <= 2;
+    long long era = (year >= 0 ? year : year - 399) / 400;
+    long long year_of_era = year - era * 400;
+    long long day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    long long day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + day_of_era - 719468;
+}
+
+// Local midnight at the start of a calendar date. Returns 0 if the date does
+// not exist (2024-02-31, year 0) or mktime() cannot represent it.
+int localMidnight(int year, int month, int day, time_t *midnight) {
+    static const unsigned char days_in_month[13] = {0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    if (year < 1 || year > 9999 || month < 1 || month > 12 || day < 1) {
+        return 0;
+    }
+    int leap = month == 2 && year % 4 == 0 && (year % 100 != 0 || year % 400 == 0);
+    if (day > days_in_month[month] + leap) {
+        return 0;
+    }
+    struct tm date;
+    memset(&date, 0, sizeof(date));
+    date.tm_year = year - 1900;
+    date.tm_mon = month - 1;
+    date.tm_mday = day;
+    date.tm_isdst = -1;
+    time_t result = mktime(&date);
+    if (result == (time_t)-1) {
+        return 0;
+    }
+    *midnight = result;
+    return 1;
+}
+
+// Adds a transaction to the growable block. Returns 0 if out of memory.
+int appendTransaction(const Transaction *transaction) {
+    uint32_t category = internCategory(transaction->category);
+    if (category == NO_CATEGORY) {
+        return 0;
+    }
+    return appendRow(transaction->amount, transaction->type == EXPENSE, (int64_t)transaction->transaction_time, category,
+                     transaction->description, strlen(transaction->description));
+}
+
+// Rounds an amount in currency units, as older files stored it, to cents
+int64_t centsFromDouble(double amount) {
+    double cents = amount * 100.0;
+    return (int64_t)(cents < 0 ? cents - 0.5 : cents + 0.5);
+}
+
+// Adds one row to the growable block, copying its description into the
+// block's string heap, and to the rollups. Returns 0 if out of memory.
+int appendRow(int64_t cents, int is_expense, int64_t when, uint32_t category,
+              const char *description, size_t description_length) {
+    TransactionBlock *block = &blocks[block_count - 1];
+    size_t desc_length = description_length + 1;
+
+    if (block->count == block->capacity) {
+        long long grown = block->capacity ? block->capacity * 2 : 64;
+        int64_t *amounts = realloc(block->amounts, (size_t)grown * sizeof(int64_t));
+        if (amounts != NULL) block->amounts = amounts;
+        int64_t *times = realloc(block->times, (size_t)grown * sizeof(int64_t));
+        if (times != NULL) block->times = times;
+        uint64_t *ends = realloc(block->desc_ends, (size_t)grown * sizeof(uint64_t));
+        if (ends != NULL) block->desc_ends = ends;
+        uint32_t *ids = realloc(block->category_ids, (size_t)grown * sizeof(uint32_t));
+        if (ids != NULL) block->category_ids = ids;
+        uint64_t *bits = realloc(block->expense_bits, (size_t)grown / 64 * sizeof(uint64_t));
+        if (bits != NULL) block->expense_bits = bits;
+        if (amounts == NULL || times == NULL || ends == NULL || ids == NULL || bits == NULL) {
+            return 0;
+        }
+        memset(bits + block->capacity / 64, 0, (size_t)(grown - block->capacity) / 64 * sizeof(uint64_t));
+        block->capacity = grown;
+    }
+    if (block->desc_heap_size + desc_length > block->desc_heap_capacity) {
+        uint64_t grown = block->desc_heap_capacity ? block->desc_heap_capacity * 2 : 4096;
+        while (grown < block->desc_heap_size + desc_length) {
+            grown *= 2;
+        }
+        char *heap = realloc(block->desc_heap, (size_t)grown);
+        if (heap == NULL) {
+            return 0;
+        }
+        block->desc_heap = heap;
+        block->desc_heap_capacity = grown;
+    }
+    RollupCell *cells[3];
+    if (!findRollupCells(when, category, cells)) {
+        return 0;
+    }
+
+    long long r = block->count;
+    block->amounts[r] = cents;
+    block->times[r] = when;
+    block->category_ids[r] = category;
+    if (is_expense) {
+        block->expense_bits[r / 64] |= (uint64_t)1 << (r % 64);
+    }
+    memcpy(block->desc_heap + block->desc_heap_size, description, description_length);
+    block->desc_heap[block->desc_heap_size + description_length] = 0;
+    block->desc_heap_size += desc_length;
+    block->desc_ends[r] = block->desc_heap_size;
+    block->count++;
+    transaction_count++;
+    addToRollups(cells, cents, is_expense);
+    noteRowTime(when);
+    return 1;
+}
+
+// Finds the block holding ledger row `index` and the row within that block
+TransactionBlock *locateRow(long long index, long long *row) {
+    int lo = 0, hi = block_count - 1;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if (blocks[mid].first_row <= index) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    *row = index - blocks[lo].first_row;
+    return &blocks[lo];
+}
+
+// Returns the description of one row of a block
+const char *rowDescription(const TransactionBlock *block, long long row) {
+    return block->desc_heap + (row > 0 ? block->desc_ends[row - 1] : 0);
+}
+
+// Starts an empty growable block after the last row. Returns 0 if out of memory.
+int addGrowableBlock() {
+    TransactionBlock *grown = realloc(blocks, (size_t)(block_count + 1) * sizeof(TransactionBlock));
+    if (grown == NULL) {
+        return 0;
+    }
+    blocks = grown;
+    memset(&blocks[block_count], 0, sizeof(TransactionBlock));
+    blocks[block_count].first_row = transaction_count;
+    block_count++;
+    return 1;
+}
+
+// Returns the id of a category name, adding a copy of it if it is new.
+// Returns NO_CATEGORY if out of memory.
+uint32_t internCategory(const char *name) {
+    uint32_t mask = category_index_size - 1;
+    for (uint32_t slot = checksumBytes(name, strlen(name)) & mask; category_index[slot] != 0;
+         slot = (slot + 1) & mask) {
+        uint32_t id = category_index[slot] - 1;
+        if (strcmp(category_names[id], name) == 0) {
+            return id;
+        }
+    }
+
+    size_t length = strlen(name) + 1;
+    char *copy = malloc(length);
+    if (copy == NULL) {
+        return NO_CATEGORY;
+    }
+    memcpy(copy, name, length);
+    if (!addCategoryName(copy) || ((category_count + 1) * 2 > category_index_size && !rebuildCategoryIndex())) {
+        free(copy);
+        return NO_CATEGORY;
+    }
+    for (uint32_t slot = checksumBytes(name, length - 1) & (category_index_size - 1); ;
+         slot = (slot + 1) & (category_index_size - 1)) {
+        if (category_index[slot] == 0) {
+            category_index[slot] = category_count + 1;
+            break;
+        }
+    }
+    return category_count++;
+}
+
+// Stores a name at id category_count without counting it yet. Returns 0 if out of memory.
+int addCategoryName(char *name) {
+    if (category_count == category_capacity) {
+        uint32_t grown = category_capacity ? category_capacity * 2 : 32;
+        char **names = realloc(category_names, grown * sizeof(char *));
+        if (names == NULL) {
+            return 0;
+        }
+        category_names = names;
+        category_capacity = grown;
+    }
+    category_names[category_count] = name;
+    return 1;
+}
+
+// Rebuilds the name index with room for at least twice the names there are.
+// Returns 0 if out of memory.
+int rebuildCategoryIndex() {
+    uint32_t size = 64;
+    while (size < (category_count + 1) * 4) {
+        size *= 2;
+    }
+    uint32_t *index = calloc(size, sizeof(uint32_t));
+    if (index == NULL) {
+        return 0;
+    }
+    for (uint32_t id = 0; id < category_count; id++) {
+        uint32_t slot = checksumBytes(category_names[id], strlen(category_names[id])) & (size - 1);
+        while (index[slot] != 0) {
+            slot = (slot + 1) & (size - 1);
+        }
+        index[slot] = id + 1;
+    }
+    free(category_index);
+    category_index = index;
+    category_index_size = size;
+    return 1;
+}
+
+// Checkpoint: writes every transaction not yet in the ledger as a new chunk
+// after the committed data, forces it to disk, then commits a header linking
+// it in, using the older slot. Trailing chunks much smaller than the new one
+// are rewritten into it, so the chain stays logarithmic in the ledger
+// size while a checkpoint costs roughly what changed. The log is
+// emptied afterwards since the ledger now holds everything it did. Returns 0
+// if the ledger could not be written.
+int saveDataToFile() {
+    if (saved_count == transaction_count) {
+        return 1;
+    }
+    FILE *file = fopen(LEDGER_FILENAME, "r+b");
+    if (file == NULL) {
+        printf("Error: Could not open file %s for writing.\n", LEDGER_FILENAME);
+        return 0;
+    }
+
+    long long rows = transaction_count - saved_count;
+    uint32_t first_category = ledger_header.category_count;
+    int keep = chunk_count;
+    while (keep > 0 && (long long)chunks[keep - 1].rows < CHUNK_MERGE_RATIO * rows) {
+        keep--;
+        rows += (long long)chunks[keep].rows;
+        first_category = chunks[keep].first_category;
+    }
+
+    LedgerHeader header = ledger_header;
+    unsigned int crc = ledger_header.data_checksum;
+    uint64_t size = 0;
+    int ok = seekFile(file, (long long)ledger_header.end_offset)
+          && writeChunk(file, transaction_count - rows, rows, first_category,
+                        keep > 0 ? chunks[keep - 1].offset : 0, &crc, &size)
+          && syncFile(file);
+    if (ok) {
+        header.chunk_count = (uint32_t)keep + 1;
+        header.count = (uint64_t)transaction_count;
+        header.generation++;
+        header.last_chunk_offset = ledger_header.end_offset;
+        header.end_offset = ledger_header.end_offset + size;
+        header.category_count = category_count;
+        header.data_checksum = crc;
+        ok = writeLedgerHeader(file, 1 - ledger_slot, &header);
+    }
+    ok = fclose(file) == 0 && ok;
+    if (!ok) {
+        printf("Error: Could not write %s; changes remain in %s.\n", LEDGER_FILENAME, LOG_FILENAME);
+        return 0;
+    }
+
+    ChunkInfo chunk = { ledger_header.end_offset, (uint64_t)(transaction_count - rows), (uint64_t)rows,
+                        size, first_category };
+    chunk_count = keep;
+    rememberChunk(&chunk);
+    ledger_header = header;
+    ledger_slot = 1 - ledger_slot;
+    saved_count = transaction_count;
+
+    // Log records below saved_count are skipped on replay, so a crash before
+    // this truncation cannot apply them twice
+    if (log_file != NULL) {
+        fclose(log_file);
+    }
+    log_file = fopen(LOG_FILENAME, "wb");
+    logged_since_checkpoint = 0;
+    return 1;
+}
+
+// Rewrites the ledger as a single chunk once merged-away chunks leave more
+// dead bytes in the file than live ones. Only called on exit, since the
+// loaded blocks are mapped from the file being replaced.
+void compactLedger() {
+    uint64_t live = 0;
+    for (int i = 0; i < chunk_count; i++) {
+        live += chunks[i].total_size;
+    }
+    if (saved_count != transaction_count || ledger_header.end_offset - LEDGER_DATA_OFFSET <= 2 * live) {
+        return;
+    }
+    const char *temp_name = LEDGER_FILENAME ".tmp";
+    LedgerHeader header;
+    ChunkInfo chunk;
+    if (writeLedgerSnapshot(temp_name, &header, &chunk)) {
+        unmapFile(&ledger_map);
+        replaceFile(temp_name, LEDGER_FILENAME);
+    }
+}
+
+// Writes a complete ledger with every transaction in one chunk to `path` and
+// syncs it, returning its header and chunk. Returns 0 on failure.
+int writeLedgerSnapshot(const char *path, LedgerHeader *header, ChunkInfo *chunk) {
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        return 0;
+    }
+    LedgerHeader empty;
+    memset(&empty, 0, sizeof(empty));
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, LEDGER_MAGIC, 8);
+    header->version = LEDGER_VERSION;
+    header->generation = 1;
+    header->end_offset = LEDGER_DATA_OFFSET;
+
+    unsigned int crc = 0;
+    uint64_t size = 0;
+    int ok = fwrite(&empty, sizeof(empty), 1, file) == 1 && fwrite(&empty, sizeof(empty), 1, file) == 1;
+    if (ok && transaction_count > 0) {
+        ok = writeChunk(file, 0, transaction_count, 0, 0, &crc, &size);
+        header->chunk_count = 1;
+        header->last_chunk_offset = LEDGER_DATA_OFFSET;
+        header->end_offset += size;
+    }
+    header->count = (uint64_t)transaction_count;
+    header->category_count = category_count;
+    header->data_checksum = crc;
+    ok = ok && syncFile(file) && writeLedgerHeader(file, 0, header);
+    ok = fclose(file) == 0 && ok;
+
+    chunk->offset = LEDGER_DATA_OFFSET;
+    chunk->first_row = 0;
+    chunk->rows = (uint64_t)transaction_count;
+    chunk->total_size = size;
+    chunk->first_category = 0;
+    return ok;
+}
+
+// Writes rows [first_row, first_row + rows) as one chunk at the current file
+// position, with the names of categories from first_category on. The bytes
+// written are added to *crc and their count stored in *size.
+int writeChunk(FILE *file, long long first_row, long long rows, uint32_t first_category,
+               uint64_t prev_offset, unsigned int *crc, uint64_t *size) {
+    ChunkHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CHUNK_MAGIC, 4);
+    header.first_category = first_category;
+    header.new_categories = category_count - first_category;
+    header.first_row = (uint64_t)first_row;
+    header.rows = (uint64_t)rows;
+    header.prev_offset = prev_offset;
+    for (long long row = first_row; row < first_row + rows; ) {
+        long long r;
+        TransactionBlock *block = locateRow(row, &r);
+        long long n = block->count - r < first_row + rows - row ? block->count - r : first_row + rows - row;
+        header.desc_heap_size += block->desc_ends[r + n - 1] - (r > 0 ? block->desc_ends[r - 1] : 0);
+        row += n;
+    }
+    for (uint32_t id = first_category; id < category_count; id++) {
+        header.category_bytes += strlen(category_names[id]) + 1;
+    }
+    uint64_t n = (uint64_t)rows;
+    header.total_size = chunkSize(n, header.desc_heap_size, header.category_bytes);
+    header.header_checksum = crc32Update(0, &header, sizeof(header));
+
+    static const char zeros[8] = {0};
+    int ok = writeTracked(file, &header, sizeof(header), crc);
+    for (int column = 0; column < COLUMN_COUNT && ok; column++) {
+        ok = writeColumn(file, column, first_row, rows, crc);
+        if (column == COLUMN_CATEGORY_IDS) {
+            ok = ok && writeTracked(file, zeros, PAD8(4 * n) - 4 * n, crc);
+        }
+    }
+    ok = ok && writeTracked(file, zeros, PAD8(header.desc_heap_size) - header.desc_heap_size, crc);
+    for (uint32_t id = first_category; id < category_count && ok; id++) {
+        ok = writeTracked(file, category_names[id], strlen(category_names[id]) + 1, crc);
+    }
+    ok = ok && writeTracked(file, zeros, PAD8(header.category_bytes) - header.category_bytes, crc);
+    *size = header.total_size;
+    return ok;
+}
+
+// Streams one column of rows [first_row, first_row + rows) from however many
+// blocks they span. Description offsets are rebased and the expense bitmap
+// re-packed, since the range need not start at a block or word boundary.
+int writeColumn(FILE *file, int column, long long first_row, long long rows, unsigned int *crc) {
+    uint64_t buffer[512];
+    int buffered = 0;
+    uint64_t desc_base = 0;
+    uint64_t bits = 0;
+    int bit_count = 0;
+    int ok = 1;
+
+    for (long long row = first_row; row < first_row + rows && ok; ) {
+        long long r;
+        TransactionBlock *block = locateRow(row, &r);
+        long long n = block->count - r < first_row + rows - row ? block->count - r : first_row + rows - row;
+        uint64_t heap_start = r > 0 ? block->desc_ends[r - 1] : 0;
+
+        switch (column) {
+            case COLUMN_AMOUNTS:
+                ok = writeTracked(file, block->amounts + r, (size_t)n * sizeof(int64_t), crc);
+                break;
+            case COLUMN_TIMES:
+                ok = writeTracked(file, block->times + r, (size_t)n * sizeof(int64_t), crc);
+                break;
+            case COLUMN_CATEGORY_IDS:
+                ok = writeTracked(file, block->category_ids + r, (size_t)n * sizeof(uint32_t), crc);
+                break;
+            case COLUMN_DESC_HEAP:
+                ok = writeTracked(file, block->desc_heap + heap_start,
+                                  (size_t)(block->desc_ends[r + n - 1] - heap_start), crc);
+                break;
+            case COLUMN_DESC_ENDS:
+                for (long long i = r; i < r + n && ok; i++) {
+                    buffer[buffered++] = desc_base + block->desc_ends[i] - heap_start;
+                    if (buffered == 512) {
+                        ok = writeTracked(file, buffer, sizeof(buffer), crc);
+                        buffered = 0;
+                    }
+                }
+                desc_base += block->desc_ends[r + n - 1] - heap_start;
+                break;
+            case COLUMN_EXPENSE_BITS:
+                for (long long i = r; i < r + n && ok; i++) {
+                    bits |= (block->expense_bits[i / 64] >> (i % 64) & 1) << bit_count;
+                    if (++bit_count == 64) {
+                        buffer[buffered++] = bits;
+                        bits = 0;
+                        bit_count = 0;
+                        if (buffered == 512) {
+                            ok = writeTracked(file, buffer, sizeof(buffer), crc);
+                            buffered = 0;
+                        }
+                    }
+                }
+                break;
+        }
+        row += n;
+    }
+    if (bit_count > 0) {
+        buffer[buffered++] = bits;
+    }
+    return ok && writeTracked(file, buffer, (size_t)buffered * sizeof(uint64_t), crc);
+}
+
+// fwrite() that also extends a running CRC-32. Returns 0 on failure.
+int writeTracked(FILE *file, const void *data, size_t length, unsigned int *crc) {
+    *crc = crc32Update(*crc, data, length);
+    return fwrite(data, 1, length, file) == length;
+}
+
+// Adds a chunk to the in-memory list of live chunks. Returns 0 if out of memory.
+int rememberChunk(const ChunkInfo *chunk) {
+    if (chunk_count == chunk_capacity) {
+        int grown = chunk_capacity ? chunk_capacity * 2 : 16;
+        ChunkInfo *list = realloc(chunks, (size_t)grown * sizeof(ChunkInfo));
+        if (list == NULL) {
+            return 0;
+        }
+        chunks = list;
+        chunk_capacity = grown;
+    }
+    chunks[chunk_count++] = *chunk;
+    return 1;
+}
+
+// Size in bytes of a chunk with the given contents, header included
+uint64_t chunkSize(uint64_t rows, uint64_t desc_heap_size, uint64_t category_bytes) {
+    return sizeof(ChunkHeader) + 3 * 8 * rows + 8 * ((rows + 63) / 64) + PAD8(4 * rows)
+         + PAD8(desc_heap_size) + PAD8(category_bytes);
+}
+
+// Writes a header into one of the two slots (with its checksum) and syncs it
+int writeLedgerHeader(FILE *file, int slot, const LedgerHeader *header) {
+    LedgerHeader copy = *header;
+    copy.header_checksum = crc32Update(0, &copy, offsetof(LedgerHeader, header_checksum));
+    return seekFile(file, (long long)slot * LEDGER_HEADER_SIZE)
+        && fwrite(&copy, sizeof(copy), 1, file) == 1
+        && syncFile(file);
+}
+
+// Maps the ledger, adopts the newest valid header and points a block at each
+// chunk's columns in place. Nothing is parsed or copied, but the rows are
+// still read once to check them and to rebuild the rollups and time order,
+// which are not stored, so startup is a sequential scan of the columns.
+// Version 1 ledgers are converted. Returns 0 if the ledger is missing or unusable.
+int openLedger() {
+    if (!mapFile(LEDGER_FILENAME, &ledger_map)) {
+        return 0;
+    }
+    int best = -1;
+    for (int slot = 0; slot < 2; slot++) {
+        LedgerHeader h;
+        if (ledger_map.size < LEDGER_DATA_OFFSET) {
+            break;
+        }
+        memcpy(&h, ledger_map.data + slot * LEDGER_HEADER_SIZE, sizeof(h));
+        if (memcmp(h.magic, LEDGER_MAGIC, 8) == 0 && h.version == 1) {
+            return convertLedgerV1();
+        }
+        if (memcmp(h.magic, LEDGER_MAGIC, 8) != 0 ||
+            h.header_checksum != crc32Update(0, &h, offsetof(LedgerHeader, header_checksum))) {
+            continue; // Never written, or torn by a crash mid-commit
+        }
+        if (best < 0 || h.generation > ledger_header.generation) {
+            ledger_header = h;
+            best = slot;
+        }
+    }
+    if (best < 0) {
+        printf("Error: %s is not a valid ledger file.\n", LEDGER_FILENAME);
+        unmapFile(&ledger_map);
+        return 0;
+    }
+    if (ledger_header.version != LEDGER_VERSION) {
+        printf("Error: %s was written by an incompatible version (format %u).\n",
+               LEDGER_FILENAME, ledger_header.version);
+        unmapFile(&ledger_map);
+        return 0;
+    }
+    ledger_slot = best;
+    if (ledger_header.end_offset > ledger_map.size || !attachChunks()) {
+        printf("Error: %s is damaged.\n", LEDGER_FILENAME);
+        unmapFile(&ledger_map);
+        return 0;
+    }
+    for (int b = 0; b < block_count; b++) {
+        if (!indexBlock(&blocks[b])) {
+            printf("Error: Not enough memory to index %s.\n", LEDGER_FILENAME);
+            unmapFile(&ledger_map);
+            return 0;
+        }
+    }
+    saved_count = transaction_count;
+    return addGrowableBlock();
+}
+
+// Follows the chunk chain back from the header, then (oldest first) points a
+// block at each chunk and registers the category names it introduced.
+// Returns 0 if the chain is inconsistent.
+int attachChunks() {
+    int count = (int)ledger_header.chunk_count;
+    chunks = calloc((size_t)count + 1, sizeof(ChunkInfo));
+    blocks = calloc((size_t)count + 1, sizeof(TransactionBlock));
+    if (chunks == NULL || blocks == NULL) {
+        return 0;
+    }
+    chunk_capacity = count + 1;
+
+    uint64_t offset = ledger_header.last_chunk_offset;
+    for (int i = count - 1; i >= 0; i--) {
+        ChunkHeader h;
+        if (offset < LEDGER_DATA_OFFSET || offset % 8 != 0 || offset + sizeof(h) > ledger_header.end_offset) {
+            return 0;
+        }
+        memcpy(&h, ledger_map.data + offset, sizeof(h));
+        uint32_t stored = h.header_checksum;
+        h.header_checksum = 0;
+        if (memcmp(h.magic, CHUNK_MAGIC, 4) != 0 || stored != crc32Update(0, &h, sizeof(h)) ||
+            h.total_size > ledger_header.end_offset - offset ||
+            h.total_size != chunkSize(h.rows, h.desc_heap_size, h.category_bytes)) {
+            return 0;
+        }
+        ChunkInfo info = { offset, h.first_row, h.rows, h.total_size, h.first_category };
+        chunks[i] = info;
+        offset = h.prev_offset;
+    }
+
+    for (int i = 0; i < count; i++) {
+        ChunkHeader h;
+        memcpy(&h, ledger_map.data + chunks[i].offset, sizeof(h));
+        if (h.first_row != (uint64_t)transaction_count || h.first_category != category_count) {
+            return 0;
+        }
+        const unsigned char *p = ledger_map.data + chunks[i].offset + sizeof(h);
+        uint64_t n = h.rows;
+        TransactionBlock *block = &blocks[i];
+        block->first_row = transaction_count;
+        block->count = (long long)n;
+        block->amounts = (int64_t *)p;
+        block->times = (int64_t *)(p + 8 * n);
+        block->desc_ends = (uint64_t *)(p + 16 * n);
+        block->expense_bits = (uint64_t *)(p + 24 * n);
+        block->category_ids = (uint32_t *)(p + 24 * n + 8 * ((n + 63) / 64));
+        block->desc_heap = (char *)(p + 24 * n + 8 * ((n + 63) / 64) + PAD8(4 * n));
+        block->desc_heap_size = h.desc_heap_size;
+        if ((n > 0 && block->desc_ends[n - 1] != h.desc_heap_size) ||
+            (h.category_bytes > 0 && block->desc_heap[PAD8(h.desc_heap_size) + h.category_bytes - 1] != 0)) {
+            return 0;
+        }
+
+        // Names are used in place in the mapped file
+        char *name = block->desc_heap + PAD8(h.desc_heap_size);
+        for (uint32_t c = 0; c < h.new_categories; c++) {
+            if (name >= block->desc_heap + PAD8(h.desc_heap_size) + h.category_bytes || !addCategoryName(name)) {
+                return 0;
+            }
+            category_count++;
+            name += strlen(name) + 1;
+        }
+        if (!checkBlock(block)) {
+            return 0;
+        }
+        transaction_count += (long long)n;
+        block_count++;
+    }
+    chunk_count = count;
+    if ((uint64_t)transaction_count != ledger_header.count || category_count != ledger_header.category_count) {
+        return 0;
+    }
+    return rebuildCategoryIndex();
+}
+
+// Checks that every row of a mapped block names a known category and a
+// NUL-terminated description inside the block's heap, so a damaged chunk
+// cannot send a later read outside the file. Returns 0 if one does not.
+int checkBlock(const TransactionBlock *block) {
+    uint64_t previous = 0;
+    for (long long r = 0; r < block->count; r++) {
+        uint64_t desc_end = block->desc_ends[r];
+        if (block->category_ids[r] >= category_count || desc_end <= previous ||
+            desc_end > block->desc_heap_size || block->desc_heap[desc_end - 1] != 0) {
+            return 0;
+        }
+        previous = desc_end;
+    }
+    return 1;
+}
+
+// Converts a version 1 ledger (a raw Transaction struct per record) by
+// loading every record and writing a version 2 ledger in its place.
+// Returns 0 on failure.
+int convertLedgerV1() {
+    LedgerHeaderV1 best;
+    int found = 0;
+    memset(&best, 0, sizeof(best));
+    for (int slot = 0; slot < 2; slot++) {
+        LedgerHeaderV1 h;
+        memcpy(&h, ledger_map.data + slot * LEDGER_HEADER_SIZE, sizeof(h));
+        if (memcmp(h.magic, LEDGER_MAGIC, 8) == 0 && h.version == 1 &&
+            h.header_checksum == crc32Update(0, &h, offsetof(LedgerHeaderV1, header_checksum)) &&
+            (!found || h.generation > best.generation)) {
+            best = h;
+            found = 1;
+        }
+    }
+    if (!found || best.record_size != sizeof(Transaction) ||
+        best.count > (ledger_map.size - LEDGER_DATA_OFFSET) / sizeof(Transaction)) {
+        printf("Error: %s is a version 1 ledger that cannot be read on this platform.\n", LEDGER_FILENAME);
+        unmapFile(&ledger_map);
+        return 0;
+    }
+    if (!rebuildCategoryIndex() || !addGrowableBlock()) {
+        unmapFile(&ledger_map);
+        return 0;
+    }
+    const Transaction *records = (const Transaction *)(ledger_map.data + LEDGER_DATA_OFFSET);
+    for (uint64_t i = 0; i < best.count; i++) {
+        if (!appendTransaction(&records[i])) {
+            unmapFile(&ledger_map);
+            return 0;
+        }
+    }
+    unmapFile(&ledger_map);
+
+    const char *temp_name = LEDGER_FILENAME ".tmp";
+    ChunkInfo chunk;
+    if (!writeLedgerSnapshot(temp_name, &ledger_header, &chunk) || !replaceFile(temp_name, LEDGER_FILENAME)) {
+        printf("Error: Could not convert %s to ledger format %d.\n", LEDGER_FILENAME, LEDGER_VERSION);
+        return 0;
+    }
+    ledger_slot = 0;
+    if (transaction_count > 0) {
+        rememberChunk(&chunk);
+    }
+    saved_count = transaction_count;
+    printf("Converted %s to ledger format %d.\n", LEDGER_FILENAME, LEDGER_VERSION);
+    return 1;
+}
+
+// Creates an empty ledger file. Returns 0 on failure.
+int createLedger() {
+    FILE *file = fopen(LEDGER_FILENAME, "wb");
+    if (file == NULL) {
+        return 0;
+    }
+    LedgerHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, LEDGER_MAGIC, 8);
+    header.version = LEDGER_VERSION;
+    header.generation = 1;
+    header.end_offset = LEDGER_DATA_OFFSET;
+
+    // Slot 1 starts out zeroed, which never passes validation
+    LedgerHeader empty;
+    memset(&empty, 0, sizeof(empty));
+    int ok = writeLedgerHeader(file, 0, &header)
+          && fwrite(&empty, sizeof(empty), 1, file) == 1
+          && syncFile(file);
+    return fclose(file) == 0 && ok;
+}
+
+// Checks every committed byte of the ledger against the checksum in the header
+void verifyLedger() {
+    FILE *file = fopen(LEDGER_FILENAME, "rb");
+    if (file == NULL) {
+        printf("Error: Could not open file %s for reading.\n", LEDGER_FILENAME);
+        return;
+    }
+    static unsigned char buffer[1 << 16];
+    unsigned int crc = 0;
+    uint64_t remaining = ledger_header.end_offset - LEDGER_DATA_OFFSET;
+    if (seekFile(file, LEDGER_DATA_OFFSET)) {
+        size_t got;
+        while (remaining > 0 &&
+               (got = fread(buffer, 1, remaining < sizeof(buffer) ? (size_t)remaining : sizeof(buffer), file)) > 0) {
+            crc = crc32Update(crc, buffer, got);
+            remaining -= got;
+        }
+    }
+    fclose(file);
+
+    printf("--- Ledger Integrity ---\n");
+    printf("Committed transactions: %lld in %d chunks (format %u, generation %llu)\n",
+           saved_count, chunk_count, ledger_header.version, (unsigned long long)ledger_header.generation);
+    printf("Unsaved transactions:   %lld\n", transaction_count - saved_count);
+    printf("Categories:             %u\n", category_count);
+    if (remaining == 0 && crc == ledger_header.data_checksum) {
+        printf("Checksum OK.\n");
+    } else {
+        printf("Checksum MISMATCH: the ledger file is damaged.\n");
+    }
+}
+
+// Appends the transactions of a pre-ledger money_data.dat (an int count then
+// raw Transaction structs). Fields are decoded at their fixed offsets, and the
+// trailing time_t may be 32 or 64 bits wide depending on the compiler that
+// wrote the file. Returns the number imported, or -1 if the file is unusable.
+long long importLegacyData(const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return -1;
+    }
+    int count = 0;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (fread(&count, sizeof(int), 1, file) != 1 || count < 0 || (count > 0 && (size - 4) % count != 0)) {
+        fclose(file);
+        return -1;
+    }
+    long record_size = count > 0 ? (size - 4) / count : 0;
+    if (count > 0 && record_size < 216) {
+        fclose(file);
+        return -1;
+    }
+
+    unsigned char raw[512];
+    long long imported = 0;
+    for (int i = 0; i < count && record_size <= (long)sizeof(raw); i++) {
+        if (fread(raw, (size_t)record_size, 1, file) != 1) {
+            break;
+        }
+        Transaction t;
+        int type;
+        double amount;
+        memset(&t, 0, sizeof(t));
+        memcpy(&amount, raw, sizeof(double));
+        t.amount = centsFromDouble(amount);
+        memcpy(&type, raw + 8, sizeof(int));
+        t.type = (type == EXPENSE) ? EXPENSE : INCOME;
+        memcpy(t.category, raw + 12, MAX_DESC_LENGTH);
+        memcpy(t.description, raw + 12 + MAX_DESC_LENGTH, MAX_DESC_LENGTH);
+        t.category[MAX_DESC_LENGTH - 1] = 0;
+        t.description[MAX_DESC_LENGTH - 1] = 0;
+        if (record_size >= 224) {
+            int64_t when;
+            memcpy(&when, raw + record_size - 8, sizeof(when));
+            t.transaction_time = (time_t)when;
+        } else {
+            int32_t when;
+            memcpy(&when, raw + record_size - 4, sizeof(when));
+            t.transaction_time = (time_t)when;
+        }
+        if (!appendTransaction(&t)) {
+            break;
+        }
+        imported++;
+    }
+    fclose(file);
+    return imported;
+}
+
+// Appends one transaction to the log and forces it to disk; every
+// CHECKPOINT_INTERVAL appends the log is folded into the ledger
+void appendToLog(const Transaction *transaction, long long index) {
+    if (log_file == NULL) {
+        printf("Warning: %s is not open; this transaction will be saved on exit.\n", LOG_FILENAME);
+        return;
+    }
+
+    LogRecord record;
+    memset(&record, 0, sizeof(record));
+    record.index = index;
+    record.transaction = *transaction;
+    record.checksum = checksumBytes(&record, offsetof(LogRecord, checksum)) ^ LOG_INDEX64_MARK;
+    if (fwrite(&record, sizeof(record), 1, log_file) != 1 || !syncFile(log_file)) {
+        printf("Warning: Could not write to %s; this transaction will be saved on exit.\n", LOG_FILENAME);
+        return;
+    }
+
+    if (++logged_since_checkpoint >= CHECKPOINT_INTERVAL) {
+        saveDataToFile();
+    }
+}
+
+// Appends ledger rows `first` onward to the log with a single sync, for a
+// batch whose checkpoint failed. Returns 0 if they could not all be written.
+int logRows(long long first) {
+    if (log_file == NULL) {
+        return 0;
+    }
+    LogRecord record;
+    for (long long i = first; i < transaction_count; i++) {
+        memset(&record, 0, sizeof(record));
+        record.index = i;
+        rowTransaction(i, &record.transaction);
+        record.checksum = checksumBytes(&record, offsetof(LogRecord, checksum)) ^ LOG_INDEX64_MARK;
+        if (fwrite(&record, sizeof(record), 1, log_file) != 1) {
+            return 0;
+        }
+    }
+    return syncFile(log_file);
+}
+
+// Rebuilds the Transaction for ledger row `index` from its columns
+void rowTransaction(long long index, Transaction *transaction) {
+    long long row;
+    const TransactionBlock *block = locateRow(index, &row);
+    memset(transaction, 0, sizeof(Transaction));
+    transaction->amount = block->amounts[row];
+    transaction->type = (block->expense_bits[row / 64] >> (row % 64) & 1) ? EXPENSE : INCOME;
+    snprintf(transaction->category, MAX_DESC_LENGTH, "%s", category_names[block->category_ids[row]]);
+    snprintf(transaction->description, MAX_DESC_LENGTH, "%s", rowDescription(block, row));
+    transaction->transaction_time = (time_t)block->times[row];
+}
+
+// Applies log records that are newer than the ledger. Stops at the first
+// torn or out-of-sequence record. Returns how many records were applied.
+long long replayLog() {
+    FILE *file = fopen(LOG_FILENAME, "rb");
+    if (file == NULL) {
+        return 0;
+    }
+    LogRecord record;
+    long long applied = 0;
+    while (fread(&record, sizeof(record), 1, file) == 1) {
+        unsigned int checksum = checksumBytes(&record, offsetof(LogRecord, checksum));
+        if (record.checksum != (checksum ^ LOG_INDEX64_MARK)) {
+            int narrow_index; // Written before the index was 64 bits; the rest of its field was padding
+            memcpy(&narrow_index, &record.index, sizeof(narrow_index));
+            if (record.checksum == checksum) {
+                double amount; // Written before amounts were kept in cents
+                memcpy(&amount, &record.transaction.amount, sizeof(double));
+                record.transaction.amount = centsFromDouble(amount);
+            } else if (record.checksum != (checksum ^ LOG_CENTS_MARK)) {
+                break; // Torn write from a crash; nothing after it was acknowledged
+            }
+            record.index = narrow_index;
+        }
+        if (record.index < transaction_count) {
+            continue; // Already part of the last checkpoint
+        }
+        if (record.index != transaction_count || !appendTransaction(&record.transaction)) {
+            break;
+        }
+        applied++;
+    }
+    fclose(file);
+    return applied;
+}
+
+// Opens the log for appending, folding in anything left over from the last run
+void openLog() {
+    FILE *file = fopen(LOG_FILENAME, "rb");
+    if (file != NULL) {
+        fseek(file, 0, SEEK_END);
+        long size = ftell(file);
+        fclose(file);
+        if (size > 0) {
+            saveDataToFile(); // Commits what was replayed and empties the log
+            if (log_file == NULL) {
+                // Nothing new to commit: drop stale or torn records, unless the commit failed
+                log_file = fopen(LOG_FILENAME, saved_count == transaction_count ? "wb" : "ab");
+            }
+            return;
+        }
+    }
+    log_file = fopen(LOG_FILENAME, "ab");
+}
+
+// Opens the ledger (creating it, and importing money_data.dat, on first run)
+// and replays the log on top
+void loadDataFromFile() {
+    long long imported = -1;
+    if (!openLedger()) {
+        FILE *existing = fopen(LEDGER_FILENAME, "rb");
+        if (existing != NULL) {
+            // Present but unusable: refuse to overwrite it
+            fclose(existing);
+            printf("Please move %s aside and restart. Exiting.\n", LEDGER_FILENAME);
+            exit(1);
+        }
+        if (!createLedger() || !openLedger()) {
+            printf("Error: Could not create %s. Exiting.\n", LEDGER_FILENAME);
+            exit(1);
+        }
+        imported = importLegacyData(FILENAME);
+        if (imported > 0) {
+            saveDataToFile();
+        }
+    }
+
+    long long recovered = replayLog();
+    openLog();
+    if (transaction_count == 0) {
+        // Nothing stored yet, it's the first run. Do nothing.
+        return;
+    }
+
+    printf("Data loaded successfully from %s.\n", LEDGER_FILENAME);
+    if (imported > 0) {
+        printf("Imported %lld transactions from %s.\n", imported, FILENAME);
+    }
+    if (recovered > 0) {
+        printf("Recovered %lld unsaved transactions from %s.\n", recovered, LOG_FILENAME);
+    }
+    printf("Press Enter to continue...");
+    getchar();
+}
+
+// 32-bit FNV-1a hash, used as the log record checksum and for category lookup
+unsigned int checksumBytes(const void *data, size_t length) {
+    const unsigned char *bytes = (const unsigned char *)data;
+    unsigned int hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// Extends a CRC-32 (IEEE 802.3) over more data; start from 0. Because the
+// running value can be resumed, a commit only checksums the bytes it adds.
+unsigned int crc32Update(unsigned int crc, const void *data, size_t length) {
+    static unsigned int table[256];
+    static int table_ready = 0;
+    if (!table_ready) {
+        for (unsigned int i = 0; i < 256; i++) {
+            unsigned int c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+        table_ready = 1;
+    }
+    const unsigned char *bytes = (const unsigned char *)data;
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++) {
+        crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+// Flushes stdio buffers and forces the file's data to disk. Returns 0 on failure.
+int syncFile(FILE *file) {
+    if (fflush(file) != 0) {
+        return 0;
+    }
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+// Seeks to an absolute 64-bit offset. Returns 0 on failure.
+int seekFile(FILE *file, long long offset) {
+#ifdef _WIN32
+    return _fseeki64(file, offset, SEEK_SET) == 0;
+#else
+    return fseeko(file, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+// Renames `from` over `to`, replacing it atomically. Returns 0 on failure.
+int replaceFile(const char *from, const char *to) {
+#ifdef _WIN32
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return rename(from, to) == 0;
+#endif
+}
+
+// Maps a whole file read-only. Returns 0 on failure; empty files map to size 0.
+int mapFile(const char *path, MappedFile *file) {
+    file->data = NULL;
+    file->size = 0;
+#ifdef _WIN32
+    LARGE_INTEGER size;
+    file->mapping = NULL;
+    file->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                             OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file->file == INVALID_HANDLE_VALUE) {
+        return 0;
+    }
+    if (!GetFileSizeEx(file->file, &size) || (unsigned long long)size.QuadPart > (size_t)-1) {
+        CloseHandle(file->file);
+        file->file = INVALID_HANDLE_VALUE;
+        return 0;
+    }
+    file->size = (size_t)size.QuadPart;
+    if (file->size == 0) {
+        return 1;
+    }
+    file->mapping = CreateFileMappingA(file->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (file->mapping != NULL) {
+        file->data = (const unsigned char *)MapViewOfFile(file->mapping, FILE_MAP_READ, 0, 0, 0);
+    }
+    if (file->data == NULL) {
+        unmapFile(file);
+        return 0;
+    }
+#else
+    struct stat st;
+    file->fd = open(path, O_RDONLY);
+    if (file->fd < 0) {
+        return 0;
+    }
+    if (fstat(file->fd, &st) != 0 || (unsigned long long)st.st_size > (size_t)-1) {
+        close(file->fd);
+        file->fd = -1;
+        return 0;
+    }
+    file->size = (size_t)st.st_size;
+    if (file->size == 0) {
+        return 1;
+    }
+    void *data = mmap(NULL, file->size, PROT_READ, MAP_SHARED, file->fd, 0);
+    if (data == MAP_FAILED) {
+        close(file->fd);
+        file->fd = -1;
+        return 0;
+    }
+    file->data = (const unsigned char *)data;
+#endif
+    return 1;
+}
+
+// Releases a mapping created by mapFile(). Safe to call again afterwards.
+void unmapFile(MappedFile *file) {
+#ifdef _WIN32
+    if (file->data != NULL) UnmapViewOfFile(file->data);
+    if (file->mapping != NULL) CloseHandle(file->mapping);
+    if (file->file != INVALID_HANDLE_VALUE) CloseHandle(file->file);
+    file->mapping = NULL;
+    file->file = INVALID_HANDLE_VALUE;
+#else
+    if (file->data != NULL) munmap((void *)file->data, file->size);
+    if (file->fd >= 0) close(file->fd);
+    file->fd = -1;
+#endif
+    file->data = NULL;
+    file->size = 0;
+}
+
+// Starts a thread running func(arg). Returns 0 on failure.
+int startThread(ThreadHandle *thread, ThreadFunc func, void *arg) {
+#ifdef _WIN32
+    *thread = CreateThread(NULL, 0, func, arg, 0, NULL);
+    return *thread != NULL;
+#else
+    return pthread_create(thread, NULL, func, arg) == 0;
+#endif
+}
+
+// Waits for a thread started with startThread() to finish
+void joinThread(ThreadHandle thread) {
+#ifdef _WIN32
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+#else
+    pthread_join(thread, NULL);
+#endif
+}
+
+// Number of CPUs available, at least 1
+int cpuCount() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#endif
+}
+
+// Monotonic wall-clock time in seconds, for throughput measurements
+double nowSeconds() {
+#ifdef _WIN32
+    LARGE_INTEGER freq, now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (double)now.QuadPart / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+#endif
+}
+
+// Utility function to clear the input buffer
+void clearInputBuffer() {
+    int c;
+    while ((c = getchar()) != '\n' && c != EOF);
+}
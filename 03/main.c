@@ -1,11 +1,53 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include <time.h>
+#ifdef _WIN32
+#include <windows.h> // For CreateThread(), Sleep(), MoveFileExA(), QueryPerformanceCounter()
+#include <io.h>      // For _commit()
+#else
+#include <pthread.h>
+#include <unistd.h>  // For usleep(), fsync()
+#endif
 
-#define MAX_TASKS 500
+#define INITIAL_TASK_CAPACITY 500
 #define MAX_DESC_LENGTH 150
 #define FILENAME "tasks.dat"
+#define FILE_MAGIC "TASKDAY1"    // Unpaged tasks.dat with day-number due dates
+#define PAGED_MAGIC "TASKPG01"   // Paged tasks.dat, see saveDataToFile()
+#define PAGE_SIZE 4096
+#define PAGE_PREFIX 8            // Checksum, then page number
+#define TASKS_PER_PAGE ((PAGE_SIZE - PAGE_PREFIX) / (int)sizeof(Task))
+#define TEMP_FILENAME "tasks.dat.tmp"
+#define JOURNAL_FILENAME "tasks.dwb"
+#define JOURNAL_MAGIC "TASKDWB1"
+#define LEGACY_TASK_SIZE_32 164  // Task with a 32-bit time_t due date, as first stored
+#define LEGACY_TASK_SIZE_64 168  // ... and with a 64-bit time_t
+#define TASK_SIZE_NO_DURATION 164 // Task before duration_days, with a day-number due date
+#define DEPS_FILENAME "dependencies.dat"
+#define DEPS_TEMP_FILENAME "dependencies.dat.tmp"
+#define DEPS_MAGIC "TASKDEP1"
+#define MAX_TERM_LENGTH 32       // Longer words are indexed by their first 32 characters
+#define MAX_QUERY_WORDS 16
+#define SKIP_INTERVAL 64         // Postings between skip entries
+#define BENCH_VOCABULARY 20000
+#define BENCH_QUERIES 1000
+#define BENCH_CHECKED_QUERIES 24
+#define BENCH_EDGES_PER_TASK 4
+#define BENCH_COMPLETIONS 1000
+#define BENCH_FIRST_YEAR 1900
+#define BENCH_LAST_YEAR 2199
+#define BENCH_PASSES 20
+#define BENCH_TASKS 1000000
+#define WHEEL_BITS 6
+#define WHEEL_SIZE (1 << WHEEL_BITS)
+#define WHEEL_LEVELS 3                           // Slots of 1, 64 and 4096 days: 717 years ahead
+#define LIST_OVERFLOW (WHEEL_LEVELS * WHEEL_SIZE) // Due even later than that
+#define LIST_DUE_TODAY (LIST_OVERFLOW + 1)
+#define LIST_OVERDUE (LIST_OVERFLOW + 2)
+#define LIST_COUNT (LIST_OVERFLOW + 3)
+#define REMINDER_POLL_MS 500
 
 // Enum for task priority
 typedef enum {
@@ -21,32 +63,258 @@ typedef enum {
     COMPLETED
 } TaskStatus;
 
+// Orders viewTasks() can list tasks in
+typedef enum {
+    SORT_ENTRY,     // Order the tasks were added in
+    SORT_PRIORITY,  // High first, then by due date
+    SORT_DUE_DATE,  // Earliest first, then by priority
+    SORT_STATUS     // Pending, in progress, completed, then by priority and due date
+} TaskSort;
+
+#ifdef _WIN32
+typedef HANDLE ThreadHandle;
+typedef LPTHREAD_START_ROUTINE ThreadFunc;
+typedef CRITICAL_SECTION Mutex;
+#define THREAD_RETURN DWORD WINAPI
+#define THREAD_RESULT 0
+#else
+typedef pthread_t ThreadHandle;
+typedef void *(*ThreadFunc)(void *);
+typedef pthread_mutex_t Mutex;
+#define THREAD_RETURN void *
+#define THREAD_RESULT NULL
+#endif
+
 // Structure to hold a single task
 typedef struct {
     char description[MAX_DESC_LENGTH];
     TaskPriority priority;
     TaskStatus status;
-    time_t due_date;
+    int32_t due_day;     // Days since 1970-01-01, in the local calendar
+    int32_t duration_days; // Estimated work, at least 1; used by the plan
 } Task;
 
-// Global array and counter for tasks
-Task tasks[MAX_TASKS];
+// The ascending indices of the tasks whose description contains one word,
+// stored as varint-encoded gaps. Every SKIP_INTERVAL postings, skips records
+// the task index reached and the byte offset after it, so a search can jump
+// over runs of the list it does not need.
+typedef struct {
+    unsigned char *bytes;
+    int length;
+    int capacity;
+    int count;              // Number of tasks on the list
+    int last;               // Last task added, or -1
+    int *skips;             // Pairs: task index, offset in bytes
+    int skip_count;
+    int skip_capacity;
+} PostingList;
+
+// A position in a posting list while it is being read
+typedef struct {
+    const PostingList *list;
+    int read;               // Postings read so far
+    int offset;             // Bytes read so far
+    int value;              // Last posting read, or -1
+} PostingCursor;
+
+// Global array and counter for tasks; the array grows as tasks are added
+Task *tasks = NULL;
 int task_count = 0;
+int task_capacity = 0;
+
+// "Next up" schedule: a binary heap of the indices of all tasks that are not
+// completed, best first (see taskBefore()). schedule_pos[i] is where task i
+// sits in the heap, or -1 if it is not there, so a task whose status changes
+// can be moved without a search.
+int *schedule = NULL;
+int schedule_size = 0;
+int *schedule_pos = NULL;
+
+// Persistence: tasks.dat is a header page followed by pages of
+// TASKS_PER_PAGE tasks. Changing a task sets its page's bit in dirty_pages,
+// and a save writes back only those pages, plus the header if the count
+// changed.
+uint64_t *dirty_pages = NULL;
+int header_dirty = 0;
+int file_is_paged = 0;       // tasks.dat exists and is in the paged format
+
+// Dependencies: edge i says task dep_task[i] cannot start before task
+// dep_prereq[i] is completed. Edges are only accepted if they keep the graph
+// acyclic, and are stored in dependencies.dat.
+int *dep_task = NULL;
+int *dep_prereq = NULL;
+int dep_count = 0;
+int dep_capacity = 0;
+int dependencies_dirty = 0;
+
+// The plan, rebuilt from the edge list when tasks or edges were added (or
+// the date changed) and otherwise updated incrementally as statuses change.
+// The graph is kept in CSR form: the successors of task t are
+// succ_list[succ_offsets[t] .. succ_offsets[t + 1]), likewise predecessors.
+// For open tasks, wave is the length of the longest chain of open
+// prerequisites (tasks in the same wave can be worked on in parallel) and
+// the earliest start and finish days assume prerequisites are done back to
+// back from today; completed tasks have wave -1.
+int plan_valid = 0;
+int plan_tasks = 0;          // task_count when the plan was built
+int32_t plan_day = 0;
+int *succ_offsets = NULL, *succ_list = NULL;
+int *pred_offsets = NULL, *pred_list = NULL;
+int *topo_order = NULL;      // Every task, prerequisites first
+int *topo_rank = NULL;       // Position of each task in topo_order
+int *wave = NULL;
+int32_t *earliest_start = NULL;
+int32_t *earliest_finish = NULL;
+unsigned char *plan_marks = NULL; // Scratch for incremental updates
+
+// Search: an inverted index from each word (a lowercased run of letters and
+// digits) to the tasks whose description contains it. Terms are interned
+// through term_table, an open-addressing hash of term ids; sorted_terms
+// keeps the ids in alphabetical order for prefix queries. Descriptions never
+// change, so the index is built on load and extended by addTask().
+char *term_text = NULL;      // Every term, NUL-terminated, back to back
+int term_text_length = 0;
+int term_text_capacity = 0;
+int *term_offsets = NULL;    // Where each term starts in term_text
+PostingList *postings = NULL;
+int term_count = 0;
+int term_capacity = 0;
+int *term_table = NULL;      // Term id, or -1 for an empty slot
+int term_table_size = 0;
+int *sorted_terms = NULL;
+int sorted_valid = 1;        // Cleared while the index is built in bulk
+int search_ready = 1;        // Cleared if the index ran out of memory
+
+// Reminders: a hierarchical timer wheel over the due days of open tasks.
+// Every open task is on exactly one list: a wheel slot, the overflow list,
+// due today, or overdue. Lists are circular and doubly linked through
+// timer_next/timer_prev; entries 0..LIST_COUNT-1 are the list heads and task
+// i is entry LIST_COUNT + i (timer_prev is -1 while it is on no list).
+// Level L holds tasks due in the current 64^(L+1)-day block but not the
+// current 64^L-day one, in the slot for their 64^L-day block, so adding a
+// task is O(1) and each day only touches the tasks that fall due then, plus
+// a cascade of one slot every 64 days. The reminder thread advances the
+// wheel when the date changes; everything here is guarded by task_lock.
+int *timer_next = NULL;
+int *timer_prev = NULL;
+int32_t wheel_day = 0;       // The day "due today" refers to
+int newly_due = 0;           // Counts for the next menu banner
+int newly_overdue = 0;
+Mutex task_lock;
+ThreadHandle reminder_thread;
+int reminders_running = 0;
 
 // Function Prototypes
 void addTask();
 void updateTaskStatus();
 void viewTasks();
+void viewNextUp();
+void printTaskRow(int index);
+int buildTaskView(TaskSort sort, int status_filter, int *view);
+uint64_t taskSortKey(int index, TaskSort sort);
+void radixSortView(uint64_t *keys, int *view, int count);
+int reserveTasks(int count);
+int taskBefore(int a, int b);
+void scheduleSwap(int i, int j);
+void scheduleSiftUp(int pos);
+void scheduleSiftDown(int pos);
+void scheduleTask(int index);
+void rebuildSchedule();
+void viewReminders();
+int printTimerList(int list, int32_t only_day);
+void resetReminders(int32_t day);
+void timerInsert(int index);
+void timerRemove(int node);
+void timerLink(int list, int node);
+void timerSplice(int from, int to);
+int timerListLength(int list);
+void timerCascade(int list);
+void advanceReminders(int32_t day);
+THREAD_RETURN reminderLoop(void *arg);
+int runReminderBenchmark();
+void showPlanMenu();
+int readTaskId(const char *prompt);
+void addDependencyInteractive();
+int addDependency(int task, int prereq);
+int dependsOn(int task, int prereq);
+void viewPlan();
+void viewCriticalPath();
+int ensurePlan();
+int buildGraph();
+int computePlanTask(int t);
+void updatePlan(int task);
+void freePlan();
+int saveDependencies();
+void loadDependencies();
+int runPlanBenchmark();
+void searchTaskDescriptions();
+int searchTasks(const char *query, int **results);
+int nextTerm(const char **text, char *term, int *prefix);
+int taskHasTerm(int index, const char *term, int prefix_length);
+int isTermChar(unsigned char c);
+int indexTask(int index);
+int indexAllTasks();
+int internTerm(const char *term, int length);
+int findTermSlot(const char *term, int length);
+int lowerBoundTerm(const char *term);
+int compareTerms(const void *a, const void *b);
+int appendPosting(PostingList *list, int index);
+int readPostings(const PostingList *list, int *out, uint64_t *bits);
+int advanceCursor(PostingCursor *cursor, int target);
+void freeSearchIndex();
+int runSearchBenchmark();
+void initMutex(Mutex *mutex);
+void lockMutex(Mutex *mutex);
+void unlockMutex(Mutex *mutex);
+int startThread(ThreadHandle *thread, ThreadFunc func, void *arg);
+void joinThread(ThreadHandle thread);
+void sleepMillis(int ms);
+int lowestBit(uint64_t word);
 void saveDataToFile();
 void loadDataFromFile();
+void markTaskDirty(int index);
+int dirtyWords(int capacity);
+void buildPage(int page, unsigned char *out);
+int checkPage(const unsigned char *page, int page_no);
+int writeWholeFile();
+int writeDirtyPages();
+int recoverJournal();
+int loadPagedTasks(FILE *file, long long size);
+unsigned int checksumBytes(const void *data, size_t length);
+int syncFile(FILE *file);
+int seekFile(FILE *file, long long offset);
+int replaceFile(const char *from, const char *to);
 void displayMenu();
 void clearInputBuffer();
-time_t stringToTime(const char* date_str);
+int parseDate(const char *text, int32_t *day);
+int formatDate(int32_t day, char *out);
+int32_t daysFromCivil(int year, int month, int day);
+void civilFromDays(int32_t days, int *year, int *month, int *day);
+int32_t today();
+int loadLegacyTasks(FILE *file, long size);
+int runBenchmark();
+int checkLegacyFormats();
+double nowSeconds();
 const char* priorityToString(TaskPriority p);
 const char* statusToString(TaskStatus s);
 
-int main() {
+int main(int argc, char *argv[]) {
+    if (argc > 1) {
+        if (strcmp(argv[1], "--bench") == 0) {
+            return runBenchmark();
+        }
+        printf("Usage: %s [--bench]\n", argv[0]);
+        return 1;
+    }
+
     loadDataFromFile();
+    initMutex(&task_lock);
+    if (!reserveTasks(task_count)) {
+        printf("Error: Not enough memory. Exiting.\n");
+        return 1;
+    }
+    resetReminders(today());
+    reminders_running = startThread(&reminder_thread, reminderLoop, NULL);
     int choice;
 
     do {
@@ -72,19 +340,37 @@ int main() {
                 viewTasks();
                 break;
             case 4:
+                viewNextUp();
+                break;
+            case 5:
+                viewReminders();
+                break;
+            case 6:
+                showPlanMenu();
+                break;
+            case 7:
+                searchTaskDescriptions();
+                break;
+            case 8:
                 saveDataToFile();
                 printf("Data saved. Exiting Time Management System. Goodbye!\n");
                 break;
             default:
-                printf("Invalid choice! Please select a valid option (1-4).\n");
+                printf("Invalid choice! Please select a valid option (1-8).\n");
         }
 
-        if (choice != 4) {
+        if (choice != 8) {
             printf("\nPress Enter to return to the menu...");
             getchar();
         }
-    } while (choice != 4);
+    } while (choice != 8);
 
+    if (reminders_running) {
+        lockMutex(&task_lock);
+        reminders_running = 0;
+        unlockMutex(&task_lock);
+        joinThread(reminder_thread);
+    }
     return 0;
 }
 
@@ -95,21 +381,35 @@ void displayMenu() {
     printf("1. Add New Task\n");
     printf("2. Update Task Status\n");
     printf("3. View Tasks\n");
-    printf("4. Save and Exit\n");
+    printf("4. Next Up\n");
+    printf("5. Reminders\n");
+    printf("6. Dependencies and Plan\n");
+    printf("7. Search Tasks\n");
+    printf("8. Save and Exit\n");
     printf("=========================================\n");
+    lockMutex(&task_lock);
+    if (newly_due > 0 || newly_overdue > 0) {
+        printf("Reminder: %d task(s) now due today, %d now overdue. Choose 5 to see them.\n",
+               newly_due, newly_overdue);
+        newly_due = newly_overdue = 0;
+    }
+    unlockMutex(&task_lock);
     printf("Enter your choice: ");
 }
 
 // Adds a new task to the list
 void addTask() {
-    if (task_count >= MAX_TASKS) {
-        printf("Task limit reached.\n");
+    lockMutex(&task_lock);
+    int reserved = reserveTasks(task_count + 1);
+    unlockMutex(&task_lock);
+    if (!reserved) {
+        printf("Error: Not enough memory for another task.\n");
         return;
     }
 
     Task new_task;
     int priority_choice;
-    char date_str[11]; // YYYY-MM-DD
+    char date_str[32]; // YYYY-MM-DD
 
     printf("--- Add New Task ---\n");
     printf("Enter task description: ");
@@ -122,13 +422,66 @@ void addTask() {
     new_task.priority = (priority_choice == 3) ? HIGH : (priority_choice == 2) ? MEDIUM : LOW;
 
     printf("Enter due date (YYYY-MM-DD): ");
-    fgets(date_str, sizeof(date_str), stdin);
-    clearInputBuffer();
-    new_task.due_date = stringToTime(date_str);
+    if (fgets(date_str, sizeof(date_str), stdin) == NULL) {
+        date_str[0] = 0;
+    } else if (strchr(date_str, '\n') == NULL) {
+        clearInputBuffer();
+    }
+    if (!parseDate(date_str, &new_task.due_day)) {
+        new_task.due_day = today();
+        printf("Invalid date; the task is due today.\n");
+    }
+
+    char line[256];
+    printf("Enter estimated duration in days (default 1): ");
+    new_task.duration_days = 1;
+    if (fgets(line, sizeof(line), stdin) != NULL) {
+        if (strchr(line, '\n') == NULL) {
+            clearInputBuffer();
+        }
+        int days = atoi(line);
+        new_task.duration_days = days > 0 ? days : 1;
+    }
+
+    // Prerequisites can only be existing tasks, so this cannot make a cycle
+    printf("Enter IDs of tasks this one depends on, separated by commas (blank for none): ");
+    if (fgets(line, sizeof(line), stdin) == NULL) {
+        line[0] = 0;
+    } else if (strchr(line, '\n') == NULL) {
+        clearInputBuffer();
+    }
 
     new_task.status = PENDING; // New tasks are always pending
 
-    tasks[task_count++] = new_task;
+    lockMutex(&task_lock);
+    tasks[task_count] = new_task;
+    schedule_pos[task_count] = -1;
+    timer_prev[LIST_COUNT + task_count] = -1;
+    markTaskDirty(task_count);
+    header_dirty = 1;
+    scheduleTask(task_count);
+    timerInsert(task_count++);
+    unlockMutex(&task_lock);
+    plan_valid = 0;
+    if (search_ready && !indexTask(task_count - 1)) {
+        search_ready = 0;
+        printf("Warning: Not enough memory; search is unavailable until restart.\n");
+    }
+
+    for (char *p = line; *p != 0;) {
+        char *end;
+        long id = strtol(p, &end, 10);
+        if (end == p) {
+            p++;
+            continue;
+        }
+        if (id < 1 || id >= task_count) {
+            printf("Ignoring %ld: there is no earlier task with that ID.\n", id);
+        } else if (!addDependency(task_count - 1, (int)id - 1)) {
+            printf("Error: Not enough memory to record the dependency on task %ld.\n", id);
+        }
+        p = end;
+    }
     printf("\nTask added successfully!\n");
 }
 
@@ -159,12 +512,24 @@ void updateTaskStatus() {
     scanf("%d", &status_choice);
     clearInputBuffer();
 
+    TaskStatus status;
     switch (status_choice) {
-        case 1: tasks[task_id - 1].status = PENDING; break;
-        case 2: tasks[task_id - 1].status = IN_PROGRESS; break;
-        case 3: tasks[task_id - 1].status = COMPLETED; break;
+        case 1: status = PENDING; break;
+        case 2: status = IN_PROGRESS; break;
+        case 3: status = COMPLETED; break;
         default: printf("Invalid status choice.\n"); return;
     }
+    lockMutex(&task_lock);
+    tasks[task_id - 1].status = status;
+    markTaskDirty(task_id - 1);
+    scheduleTask(task_id - 1);
+    if (status == COMPLETED) {
+        timerRemove(LIST_COUNT + task_id - 1);
+    } else if (timer_prev[LIST_COUNT + task_id - 1] < 0) {
+        timerInsert(task_id - 1);
+    }
+    unlockMutex(&task_lock);
+    updatePlan(task_id - 1);
 
     printf("Task status updated successfully!\n");
 }
@@ -176,60 +541,2361 @@ void viewTasks() {
         return;
     }
 
+    int sort_choice, filter_choice;
+    printf("Sort by (1-Entry Order, 2-Priority, 3-Due Date, 4-Status): ");
+    if (scanf("%d", &sort_choice) != 1 || sort_choice < 1 || sort_choice > 4) {
+        sort_choice = 1;
+    }
+    clearInputBuffer();
+    printf("Show (0-All, 1-Pending, 2-In Progress, 3-Completed): ");
+    if (scanf("%d", &filter_choice) != 1 || filter_choice < 0 || filter_choice > 3) {
+        filter_choice = 0;
+    }
+    clearInputBuffer();
+
+    int *view = malloc((size_t)task_count * sizeof(int));
+    if (view == NULL) {
+        printf("Error: Not enough memory.\n");
+        return;
+    }
+    int count = buildTaskView((TaskSort)(sort_choice - 1), filter_choice - 1, view);
+    if (count < 0) {
+        printf("Error: Not enough memory.\n");
+        free(view);
+        return;
+    }
+
     printf("--- View Tasks ---\n");
     printf("%-5s | %-50s | %-10s | %-12s | %-12s\n", "ID", "Description", "Priority", "Status", "Due Date");
     printf("--------------------------------------------------------------------------------------------------\n");
 
+    for (int i = 0; i < count; i++) {
+        printTaskRow(view[i]);
+    }
+    printf("--------------------------------------------------------------------------------------------------\n");
+    printf("%d of %d tasks shown.\n", count, task_count);
+    free(view);
+}
+
+// Fills `view` with the indices of the tasks whose status is status_filter
+// (or of all tasks if it is -1), in the requested order. Tasks that compare
+// equal stay in entry order. Only indices move; the Task records are never
+// copied. Returns the number of tasks in the view, or -1 if out of memory.
+int buildTaskView(TaskSort sort, int status_filter, int *view) {
+    int count = 0;
     for (int i = 0; i < task_count; i++) {
-        char due_date_str[11];
-        strftime(due_date_str, sizeof(due_date_str), "%Y-%m-%d", localtime(&tasks[i].due_date));
+        if (status_filter < 0 || (int)tasks[i].status == status_filter) {
+            view[count++] = i;
+        }
+    }
+    if (sort == SORT_ENTRY || count < 2) {
+        return count;
+    }
+
+    uint64_t *keys = malloc((size_t)count * sizeof(uint64_t));
+    if (keys == NULL) {
+        return -1;
+    }
+    for (int i = 0; i < count; i++) {
+        keys[i] = taskSortKey(view[i], sort);
+    }
+    radixSortView(keys, view, count);
+    free(keys);
+    return count;
+}
+
+// Packs the sort fields of a task into one integer that compares in view
+// order: two bits per enum and 32 bits for the due day, biased so that
+// earlier days (including any before 1970) give smaller keys
+uint64_t taskSortKey(int index, TaskSort sort) {
+    const Task *task = &tasks[index];
+    uint64_t date = (uint64_t)((int64_t)task->due_day + ((int64_t)1 << 31));
+    uint64_t urgency = (uint64_t)(HIGH - task->priority);
+    switch (sort) {
+        case SORT_PRIORITY: return urgency << 62 | date;
+        case SORT_DUE_DATE: return date << 2 | urgency;
+        case SORT_STATUS: return (uint64_t)task->status << 62 | urgency << 60 | date;
+        default: return (uint64_t)index;
+    }
+}
+
+// Stable LSD radix sort of view by keys, one byte per pass. Passes over a
+// byte that is the same in every key (most of them, for dates close
+// together) are skipped.
+void radixSortView(uint64_t *keys, int *view, int count) {
+    uint64_t *other_keys = malloc((size_t)count * sizeof(uint64_t));
+    int *other_view = malloc((size_t)count * sizeof(int));
+    if (other_keys == NULL || other_view == NULL) {
+        // Fall back to a stable insertion sort rather than failing the view
+        for (int i = 1; i < count; i++) {
+            uint64_t key = keys[i];
+            int index = view[i], j = i;
+            for (; j > 0 && keys[j - 1] > key; j--) {
+                keys[j] = keys[j - 1];
+                view[j] = view[j - 1];
+            }
+            keys[j] = key;
+            view[j] = index;
+        }
+        free(other_keys);
+        free(other_view);
+        return;
+    }
+
+    uint64_t *from_keys = keys, *to_keys = other_keys;
+    int *from_view = view, *to_view = other_view;
+    for (int shift = 0; shift < 64; shift += 8) {
+        int counts[256] = {0};
+        for (int i = 0; i < count; i++) {
+            counts[(from_keys[i] >> shift) & 0xFF]++;
+        }
+        if (counts[(from_keys[0] >> shift) & 0xFF] == count) {
+            continue;
+        }
+        int position = 0;
+        for (int digit = 0; digit < 256; digit++) {
+            int n = counts[digit];
+            counts[digit] = position;
+            position += n;
+        }
+        for (int i = 0; i < count; i++) {
+            int slot = counts[(from_keys[i] >> shift) & 0xFF]++;
+            to_keys[slot] = from_keys[i];
+            to_view[slot] = from_view[i];
+        }
+        uint64_t *held_keys = from_keys;
+        from_keys = to_keys;
+        to_keys = held_keys;
+        int *held_view = from_view;
+        from_view = to_view;
+        to_view = held_view;
+    }
+    if (from_view != view) {
+        memcpy(view, from_view, (size_t)count * sizeof(int));
+    }
+    free(other_keys);
+    free(other_view);
+}
+
+// Shows the N tasks to work on next: in-progress before pending, then by
+// priority and due date. Walks the schedule heap best-first with a small
+// heap of candidate positions, so this is O(N log N) whatever the task count.
+void viewNextUp() {
+    if (schedule_size == 0) {
+        printf("Nothing to do: every task is completed.\n");
+        return;
+    }
+
+    int wanted;
+    printf("How many tasks to show? ");
+    if (scanf("%d", &wanted) != 1 || wanted < 1) {
+        clearInputBuffer();
+        printf("Invalid number.\n");
+        return;
+    }
+    clearInputBuffer();
+    if (wanted > schedule_size) {
+        wanted = schedule_size;
+    }
+
+    // Each shown task adds at most two children to the candidates
+    int *candidates = malloc((size_t)(wanted + 1) * sizeof(int));
+    if (candidates == NULL) {
+        printf("Error: Not enough memory.\n");
+        return;
+    }
+    int count = 1;
+    candidates[0] = 0;
+
+    printf("--- Next Up ---\n");
+    printf("%-5s | %-50s | %-10s | %-12s | %-12s\n", "ID", "Description", "Priority", "Status", "Due Date");
+    printf("--------------------------------------------------------------------------------------------------\n");
+    for (int shown = 0; shown < wanted; shown++) {
+        int pos = candidates[0];
+        printTaskRow(schedule[pos]);
+
+        // Replace the shown candidate with its children, keeping the candidates a heap
+        candidates[0] = candidates[--count];
+        for (int i = 0;;) {
+            int best = i, left = 2 * i + 1, right = 2 * i + 2;
+            if (left < count && taskBefore(schedule[candidates[left]], schedule[candidates[best]])) best = left;
+            if (right < count && taskBefore(schedule[candidates[right]], schedule[candidates[best]])) best = right;
+            if (best == i) {
+                break;
+            }
+            int held = candidates[i];
+            candidates[i] = candidates[best];
+            candidates[best] = held;
+            i = best;
+        }
+        for (int child = 2 * pos + 1; child <= 2 * pos + 2 && child < schedule_size; child++) {
+            int i = count++;
+            candidates[i] = child;
+            while (i > 0 && taskBefore(schedule[candidates[i]], schedule[candidates[(i - 1) / 2]])) {
+                int parent = candidates[(i - 1) / 2];
+                candidates[(i - 1) / 2] = candidates[i];
+                candidates[i] = parent;
+                i = (i - 1) / 2;
+            }
+        }
+    }
+    printf("--------------------------------------------------------------------------------------------------\n");
+    printf("%d of %d open tasks shown.\n", wanted, schedule_size);
+    free(candidates);
+}
+
+// Prints one row of the task table
+void printTaskRow(int index) {
+    char due_date_str[16];
+    formatDate(tasks[index].due_day, due_date_str);
+
+    printf("%-5d | %-50s | %-10s | %-12s | %-12s\n",
+           index + 1,
+           tasks[index].description,
+           priorityToString(tasks[index].priority),
+           statusToString(tasks[index].status),
+           due_date_str);
+}
+
+// Makes room for at least `count` tasks. Returns 0 if out of memory.
+int reserveTasks(int count) {
+    if (count <= task_capacity && tasks != NULL) {
+        return 1;
+    }
+    int grown = task_capacity ? task_capacity : INITIAL_TASK_CAPACITY;
+    while (grown < count) {
+        grown *= 2;
+    }
+    Task *grown_tasks = realloc(tasks, (size_t)grown * sizeof(Task));
+    if (grown_tasks != NULL) tasks = grown_tasks;
+    int *grown_schedule = realloc(schedule, (size_t)grown * sizeof(int));
+    if (grown_schedule != NULL) schedule = grown_schedule;
+    int *grown_pos = realloc(schedule_pos, (size_t)grown * sizeof(int));
+    if (grown_pos != NULL) schedule_pos = grown_pos;
+    int *grown_next = realloc(timer_next, (size_t)(LIST_COUNT + grown) * sizeof(int));
+    if (grown_next != NULL) timer_next = grown_next;
+    int *grown_prev = realloc(timer_prev, (size_t)(LIST_COUNT + grown) * sizeof(int));
+    if (grown_prev != NULL) timer_prev = grown_prev;
+    uint64_t *grown_dirty = realloc(dirty_pages, (size_t)dirtyWords(grown) * sizeof(uint64_t));
+    if (grown_dirty != NULL) dirty_pages = grown_dirty;
+    if (grown_tasks == NULL || grown_schedule == NULL || grown_pos == NULL || grown_next == NULL ||
+        grown_prev == NULL || grown_dirty == NULL) {
+        return 0;
+    }
+    int old_words = task_capacity ? dirtyWords(task_capacity) : 0;
+    memset(dirty_pages + old_words, 0, (size_t)(dirtyWords(grown) - old_words) * sizeof(uint64_t));
+    task_capacity = grown;
+    return 1;
+}
+
+// Lists open tasks that are overdue, due today and due tomorrow
+void viewReminders() {
+    lockMutex(&task_lock);
+    printf("--- Reminders ---\n");
+    printf("%-5s | %-50s | %-10s | %-12s | %-12s\n", "ID", "Description", "Priority", "Status", "Due Date");
+    printf("--------------------------------------------------------------------------------------------------\n");
+    printf("Overdue:\n");
+    int overdue = printTimerList(LIST_OVERDUE, INT32_MIN);
+    printf("Due today:\n");
+    int due = printTimerList(LIST_DUE_TODAY, INT32_MIN);
 
-        printf("%-5d | %-50s | %-10s | %-12s | %-12s\n",
-               i + 1,
-               tasks[i].description,
-               priorityToString(tasks[i].priority),
-               statusToString(tasks[i].status),
-               due_date_str);
+    // Tomorrow is in a level 0 slot unless it starts a new 64-day block
+    int32_t tomorrow = wheel_day + 1;
+    int list = LIST_OVERFLOW;
+    for (int level = 0; level < WHEEL_LEVELS; level++) {
+        int shift = WHEEL_BITS * (level + 1);
+        if (tomorrow >> shift == wheel_day >> shift) {
+            list = level * WHEEL_SIZE + ((tomorrow >> (WHEEL_BITS * level)) & (WHEEL_SIZE - 1));
+            break;
+        }
     }
+    printf("Due tomorrow:\n");
+    int upcoming = printTimerList(list, tomorrow);
     printf("--------------------------------------------------------------------------------------------------\n");
+    printf("%d overdue, %d due today, %d due tomorrow.\n", overdue, due, upcoming);
+    unlockMutex(&task_lock);
 }
 
-// Saves task data to a binary file
-void saveDataToFile() {
-    FILE *file = fopen(FILENAME, "wb");
-    if (!file) {
-        printf("Error: Could not open file %s for writing.\n", FILENAME);
+// Submenu for task dependencies and the plan derived from them
+void showPlanMenu() {
+    int choice;
+    printf("--- Dependencies and Plan ---\n");
+    printf("1. Add a Dependency\n");
+    printf("2. Plan: Open Tasks in Dependency Order\n");
+    printf("3. Critical Path\n");
+    printf("Enter your choice: ");
+    if (scanf("%d", &choice) != 1) {
+        choice = 0;
+    }
+    clearInputBuffer();
+    switch (choice) {
+        case 1: addDependencyInteractive(); break;
+        case 2: viewPlan(); break;
+        case 3: viewCriticalPath(); break;
+        default: printf("Invalid choice.\n");
+    }
+}
+
+// Prompts for a task ID. Returns the task index, or -1 if it is invalid.
+int readTaskId(const char *prompt) {
+    int id;
+    printf("%s", prompt);
+    if (scanf("%d", &id) != 1) {
+        id = 0;
+    }
+    clearInputBuffer();
+    if (id < 1 || id > task_count) {
+        printf("Invalid task ID.\n");
+        return -1;
+    }
+    return id - 1;
+}
+
+// Asks for a task and a prerequisite and records the dependency, unless it
+// would make a cycle
+void addDependencyInteractive() {
+    int task = readTaskId("Enter the ID of the task that has to wait: ");
+    if (task < 0) {
         return;
     }
-    fwrite(&task_count, sizeof(int), 1, file);
-    fwrite(tasks, sizeof(Task), task_count, file);
-    fclose(file);
+    int prereq = readTaskId("Enter the ID of the task it waits for: ");
+    if (prereq < 0) {
+        return;
+    }
+    if (task != prereq && !ensurePlan()) {
+        printf("Error: Not enough memory.\n");
+        return;
+    }
+    if (task == prereq || dependsOn(prereq, task)) {
+        printf("Error: Task %d already comes before task %d (directly or not), so this would make a cycle.\n",
+               task + 1, prereq + 1);
+        return;
+    }
+    if (!addDependency(task, prereq)) {
+        printf("Error: Not enough memory.\n");
+        return;
+    }
+    printf("Task %d now waits for task %d.\n", task + 1, prereq + 1);
 }
 
-// Loads task data from a binary file
-void loadDataFromFile() {
-    FILE *file = fopen(FILENAME, "rb");
-    if (!file) {
-        // File doesn't exist, first run.
+// Appends an edge (the caller has made sure it keeps the graph acyclic).
+// Returns 0 if out of memory.
+int addDependency(int task, int prereq) {
+    if (dep_count == dep_capacity) {
+        int grown = dep_capacity ? dep_capacity * 2 : 256;
+        int *grown_task = realloc(dep_task, (size_t)grown * sizeof(int));
+        if (grown_task != NULL) dep_task = grown_task;
+        int *grown_prereq = realloc(dep_prereq, (size_t)grown * sizeof(int));
+        if (grown_prereq != NULL) dep_prereq = grown_prereq;
+        if (grown_task == NULL || grown_prereq == NULL) {
+            return 0;
+        }
+        dep_capacity = grown;
+    }
+    dep_task[dep_count] = task;
+    dep_prereq[dep_count++] = prereq;
+    dependencies_dirty = 1;
+    plan_valid = 0;
+    return 1;
+}
+
+// Whether `task` transitively waits for `prereq`. The graph is acyclic, so
+// only tasks ranked between the two in the topological order can be on a
+// path; a forward sweep over that range marks everything reachable.
+int dependsOn(int task, int prereq) {
+    int from = topo_rank[prereq], to = topo_rank[task];
+    if (from >= to) {
+        return 0;
+    }
+    plan_marks[prereq] = 1;
+    for (int pos = from; pos < to; pos++) {
+        int u = topo_order[pos];
+        if (!plan_marks[u]) {
+            continue;
+        }
+        plan_marks[u] = 0;
+        for (int e = succ_offsets[u]; e < succ_offsets[u + 1]; e++) {
+            plan_marks[succ_list[e]] = 1;
+        }
+    }
+    int reached = plan_marks[task];
+    for (int pos = to; pos < plan_tasks; pos++) {
+        plan_marks[topo_order[pos]] = 0; // Leave the scratch clear
+    }
+    return reached;
+}
+
+// Lists open tasks wave by wave: everything in one wave can be worked on at
+// the same time once the waves before it are done
+void viewPlan() {
+    if (!ensurePlan()) {
+        printf("Error: Not enough memory.\n");
+        return;
+    }
+    int open = 0, waves = 0;
+    for (int t = 0; t < task_count; t++) {
+        if (wave[t] >= 0) {
+            open++;
+            waves = wave[t] + 1 > waves ? wave[t] + 1 : waves;
+        }
+    }
+    if (open == 0) {
+        printf("Nothing to plan: every task is completed.\n");
+        return;
+    }
+    char line[32];
+    int wanted = 0;
+    printf("How many tasks to show (blank for all)? ");
+    if (fgets(line, sizeof(line), stdin) != NULL) {
+        if (strchr(line, '\n') == NULL) {
+            clearInputBuffer();
+        }
+        wanted = atoi(line);
+    }
+    wanted = wanted > 0 ? wanted : open;
+
+    // Counting sort by wave; within a wave, topological order
+    int *starts = calloc((size_t)waves + 1, sizeof(int));
+    int *order = malloc((size_t)open * sizeof(int));
+    if (starts == NULL || order == NULL) {
+        printf("Error: Not enough memory.\n");
+        free(starts);
+        free(order);
+        return;
+    }
+    for (int t = 0; t < task_count; t++) {
+        if (wave[t] >= 0) {
+            starts[wave[t] + 1]++;
+        }
+    }
+    for (int w = 0; w < waves; w++) {
+        starts[w + 1] += starts[w];
+    }
+    for (int pos = 0; pos < task_count; pos++) {
+        int t = topo_order[pos];
+        if (wave[t] >= 0) {
+            order[starts[wave[t]]++] = t;
+        }
+    }
+
+    printf("%-5s | %-40s | %-5s | %-10s | %-10s | %-10s | %s\n", "ID", "Description", "Wave", "Start", "Finish",
+           "Due", "Days");
+    printf("--------------------------------------------------------------------------------------------------------\n");
+    for (int i = 0; i < open && i < wanted; i++) {
+        int t = order[i];
+        char start[16], finish[16], due[16];
+        formatDate(earliest_start[t], start);
+        formatDate(earliest_finish[t] - 1, finish);
+        formatDate(tasks[t].due_day, due);
+        printf("%-5d | %-40.40s | %-5d | %-10s | %-10s | %-10s | %d%s\n", t + 1, tasks[t].description, wave[t] + 1,
+               start, finish, due, tasks[t].duration_days, earliest_finish[t] - 1 > tasks[t].due_day ? "  LATE" : "");
+    }
+    printf("--------------------------------------------------------------------------------------------------------\n");
+    printf("%d open tasks in %d waves, %d dependencies.\n", open, waves, dep_count);
+    free(starts);
+    free(order);
+}
+
+// Shows the chain of open tasks that decides when everything can be done
+void viewCriticalPath() {
+    if (!ensurePlan()) {
+        printf("Error: Not enough memory.\n");
+        return;
+    }
+    int last = -1;
+    for (int t = 0; t < task_count; t++) {
+        if (wave[t] >= 0 && (last < 0 || earliest_finish[t] > earliest_finish[last])) {
+            last = t;
+        }
+    }
+    if (last < 0) {
+        printf("Nothing to plan: every task is completed.\n");
+        return;
+    }
+
+    // Walk back through the prerequisite that finishes exactly when each task starts
+    int length = 0;
+    for (int t = last; t >= 0; length++) {
+        int prev = -1;
+        for (int e = pred_offsets[t]; e < pred_offsets[t + 1] && prev < 0; e++) {
+            int p = pred_list[e];
+            if (wave[p] >= 0 && earliest_finish[p] == earliest_start[t]) {
+                prev = p;
+            }
+        }
+        plan_marks[t] = 1;
+        t = prev;
+    }
+    printf("--- Critical Path (%d tasks) ---\n", length);
+    printf("%-5s | %-40s | %-10s | %-10s | %s\n", "ID", "Description", "Start", "Finish", "Days");
+    printf("----------------------------------------------------------------------------------\n");
+    for (int pos = 0; pos < plan_tasks; pos++) {
+        int t = topo_order[pos];
+        if (!plan_marks[t]) {
+            continue;
+        }
+        plan_marks[t] = 0;
+        char start[16], finish[16];
+        formatDate(earliest_start[t], start);
+        formatDate(earliest_finish[t] - 1, finish);
+        printf("%-5d | %-40.40s | %-10s | %-10s | %d\n", t + 1, tasks[t].description, start, finish,
+               tasks[t].duration_days);
+    }
+    printf("----------------------------------------------------------------------------------\n");
+    char done[16];
+    formatDate(earliest_finish[last] - 1, done);
+    printf("Everything can be finished by %s at the earliest.\n", done);
+}
+
+// Makes sure the plan reflects the current tasks, edges and date. Returns 0
+// if out of memory.
+int ensurePlan() {
+    if (plan_valid && plan_tasks == task_count && plan_day == today()) {
+        return 1;
+    }
+    if (!buildGraph()) {
+        return 0;
+    }
+    plan_day = today();
+    for (int pos = 0; pos < task_count; pos++) {
+        computePlanTask(topo_order[pos]);
+    }
+    plan_valid = 1;
+    return 1;
+}
+
+// Builds both CSR adjacency arrays from the edge list with a counting sort,
+// then a topological order with Kahn's algorithm. Returns 0 if out of memory.
+int buildGraph() {
+    freePlan();
+    int n = task_count;
+    succ_offsets = calloc((size_t)n + 1, sizeof(int));
+    pred_offsets = calloc((size_t)n + 1, sizeof(int));
+    succ_list = malloc((size_t)(dep_count + 1) * sizeof(int));
+    pred_list = malloc((size_t)(dep_count + 1) * sizeof(int));
+    topo_order = malloc(((size_t)n + 1) * sizeof(int));
+    topo_rank = malloc(((size_t)n + 1) * sizeof(int));
+    wave = malloc(((size_t)n + 1) * sizeof(int));
+    earliest_start = malloc(((size_t)n + 1) * sizeof(int32_t));
+    earliest_finish = malloc(((size_t)n + 1) * sizeof(int32_t));
+    plan_marks = calloc((size_t)n + 1, 1);
+    if (succ_offsets == NULL || pred_offsets == NULL || succ_list == NULL || pred_list == NULL ||
+        topo_order == NULL || topo_rank == NULL || wave == NULL || earliest_start == NULL ||
+        earliest_finish == NULL || plan_marks == NULL) {
+        freePlan();
+        return 0;
+    }
+
+    for (int e = 0; e < dep_count; e++) {
+        succ_offsets[dep_prereq[e] + 1]++;
+        pred_offsets[dep_task[e] + 1]++;
+    }
+    for (int t = 0; t < n; t++) {
+        succ_offsets[t + 1] += succ_offsets[t];
+        pred_offsets[t + 1] += pred_offsets[t];
+    }
+    // Fill using topo_rank and wave as insertion cursors for now
+    memcpy(topo_rank, succ_offsets, (size_t)n * sizeof(int));
+    memcpy(wave, pred_offsets, (size_t)n * sizeof(int));
+    for (int e = 0; e < dep_count; e++) {
+        succ_list[topo_rank[dep_prereq[e]]++] = dep_task[e];
+        pred_list[wave[dep_task[e]]++] = dep_prereq[e];
+    }
+
+    // Kahn: topo_rank counts each task's prerequisites not yet placed
+    int placed = 0;
+    for (int t = 0; t < n; t++) {
+        topo_rank[t] = pred_offsets[t + 1] - pred_offsets[t];
+        if (topo_rank[t] == 0) {
+            topo_order[placed++] = t;
+        }
+    }
+    for (int head = 0; head < placed; head++) {
+        int u = topo_order[head];
+        for (int e = succ_offsets[u]; e < succ_offsets[u + 1]; e++) {
+            if (--topo_rank[succ_list[e]] == 0) {
+                topo_order[placed++] = succ_list[e];
+            }
+        }
+    }
+    for (int pos = 0; pos < placed; pos++) {
+        topo_rank[topo_order[pos]] = pos;
+    }
+    plan_tasks = n;
+    return placed == n; // Edges are checked on the way in, so never short
+}
+
+// Recomputes one task's wave and earliest start and finish from its
+// prerequisites, which must be up to date. Returns whether anything changed.
+int computePlanTask(int t) {
+    int new_wave = -1;
+    int32_t start = plan_day, finish = plan_day;
+    if (tasks[t].status != COMPLETED) {
+        new_wave = 0;
+        for (int e = pred_offsets[t]; e < pred_offsets[t + 1]; e++) {
+            int p = pred_list[e];
+            if (wave[p] >= 0) {
+                new_wave = wave[p] + 1 > new_wave ? wave[p] + 1 : new_wave;
+                start = earliest_finish[p] > start ? earliest_finish[p] : start;
+            }
+        }
+        finish = start + tasks[t].duration_days;
+    }
+    int changed = new_wave != wave[t] || start != earliest_start[t] || finish != earliest_finish[t];
+    wave[t] = new_wave;
+    earliest_start[t] = start;
+    earliest_finish[t] = finish;
+    return changed;
+}
+
+// Brings the plan up to date after one task's status changed. Only tasks
+// downstream of it can change; they are visited in topological order,
+// starting from the changed task's rank, and a task's successors are only
+// revisited if the task itself changed.
+void updatePlan(int task) {
+    if (!plan_valid || plan_tasks != task_count || plan_day != today()) {
+        plan_valid = 0; // Rebuilt in full when next needed
+        return;
+    }
+    int pending = 1;
+    plan_marks[task] = 1;
+    for (int pos = topo_rank[task]; pos < plan_tasks && pending > 0; pos++) {
+        int u = topo_order[pos];
+        if (!plan_marks[u]) {
+            continue;
+        }
+        plan_marks[u] = 0;
+        pending--;
+        if (computePlanTask(u)) {
+            for (int e = succ_offsets[u]; e < succ_offsets[u + 1]; e++) {
+                if (!plan_marks[succ_list[e]]) {
+                    plan_marks[succ_list[e]] = 1;
+                    pending++;
+                }
+            }
+        }
+    }
+}
+
+// Releases the CSR arrays and the plan
+void freePlan() {
+    free(succ_offsets);
+    free(succ_list);
+    free(pred_offsets);
+    free(pred_list);
+    free(topo_order);
+    free(topo_rank);
+    free(wave);
+    free(earliest_start);
+    free(earliest_finish);
+    free(plan_marks);
+    succ_offsets = succ_list = pred_offsets = pred_list = topo_order = topo_rank = wave = NULL;
+    earliest_start = earliest_finish = NULL;
+    plan_marks = NULL;
+    plan_valid = 0;
+}
+
+// Writes every dependency to a temporary file and renames it over
+// dependencies.dat. Returns 0 on failure.
+int saveDependencies() {
+    FILE *file = fopen(DEPS_TEMP_FILENAME, "wb");
+    if (file == NULL) {
+        return 0;
+    }
+    uint32_t count = (uint32_t)dep_count;
+    uint32_t checksum = checksumBytes(dep_task, (size_t)dep_count * sizeof(int)) ^
+                        checksumBytes(dep_prereq, (size_t)dep_count * sizeof(int));
+    int ok = fwrite(DEPS_MAGIC, 8, 1, file) == 1 && fwrite(&count, sizeof(count), 1, file) == 1 &&
+             fwrite(&checksum, sizeof(checksum), 1, file) == 1 &&
+             fwrite(dep_task, sizeof(int), (size_t)dep_count, file) == (size_t)dep_count &&
+             fwrite(dep_prereq, sizeof(int), (size_t)dep_count, file) == (size_t)dep_count;
+    ok = syncFile(file) && ok;
+    ok = fclose(file) == 0 && ok;
+    if (!ok || !replaceFile(DEPS_TEMP_FILENAME, DEPS_FILENAME)) {
+        remove(DEPS_TEMP_FILENAME);
+        return 0;
+    }
+    dependencies_dirty = 0;
+    return 1;
+}
+
+// Loads dependencies.dat, if there is one. Edges naming tasks that do not
+// exist are dropped; a damaged file is ignored (and replaced on save).
+void loadDependencies() {
+    FILE *file = fopen(DEPS_FILENAME, "rb");
+    if (file == NULL) {
         return;
     }
-    fread(&task_count, sizeof(int), 1, file);
-    fread(tasks, sizeof(Task), task_count, file);
+    char magic[8];
+    uint32_t count = 0, checksum = 0;
+    int ok = fread(magic, 8, 1, file) == 1 && memcmp(magic, DEPS_MAGIC, 8) == 0 &&
+             fread(&count, sizeof(count), 1, file) == 1 && fread(&checksum, sizeof(checksum), 1, file) == 1 &&
+             count <= (uint32_t)INT32_MAX / 2;
+    int *task_ids = ok ? malloc(((size_t)count + 1) * sizeof(int)) : NULL;
+    int *prereq_ids = ok ? malloc(((size_t)count + 1) * sizeof(int)) : NULL;
+    ok = ok && task_ids != NULL && prereq_ids != NULL &&
+         fread(task_ids, sizeof(int), count, file) == count && fread(prereq_ids, sizeof(int), count, file) == count &&
+         checksum == (checksumBytes(task_ids, (size_t)count * sizeof(int)) ^
+                      checksumBytes(prereq_ids, (size_t)count * sizeof(int)));
     fclose(file);
-    printf("Task data loaded successfully from %s.\n", FILENAME);
-    printf("Press Enter to continue...");
-    getchar();
+    if (!ok) {
+        printf("Warning: %s is damaged; dependencies were not loaded.\n", DEPS_FILENAME);
+        free(task_ids);
+        free(prereq_ids);
+        return;
+    }
+    for (uint32_t e = 0; e < count; e++) {
+        if (task_ids[e] >= 0 && task_ids[e] < task_count && prereq_ids[e] >= 0 && prereq_ids[e] < task_count &&
+            task_ids[e] != prereq_ids[e] && !addDependency(task_ids[e], prereq_ids[e])) {
+            break;
+        }
+    }
+    free(task_ids);
+    free(prereq_ids);
+    dependencies_dirty = (int)count != dep_count;
+    if (!ensurePlan()) {
+        // A cycle (from a hand-edited file) or no memory: keep the tasks, drop the plan
+        printf("Warning: The dependencies in %s could not be used.\n", DEPS_FILENAME);
+        dep_count = 0;
+        dependencies_dirty = 1;
+        freePlan();
+    }
+}
+
+// Asks for words and lists the tasks whose descriptions contain all of them
+void searchTaskDescriptions() {
+    if (!search_ready) {
+        printf("Error: Search is unavailable (not enough memory to index the tasks).\n");
+        return;
+    }
+    char query[256];
+    printf("Search for (tasks must contain every word; end a word with * to match its beginning): ");
+    if (fgets(query, sizeof(query), stdin) == NULL) {
+        return;
+    }
+    if (strchr(query, '\n') == NULL) {
+        clearInputBuffer();
+    }
+
+    int *results;
+    int count = searchTasks(query, &results);
+    if (count < 0) {
+        printf("Error: Not enough memory.\n");
+        return;
+    }
+    printf("--- Search Results ---\n");
+    printf("%-5s | %-50s | %-10s | %-12s | %-12s\n", "ID", "Description", "Priority", "Status", "Due Date");
+    printf("--------------------------------------------------------------------------------------------------\n");
+    for (int i = 0; i < count; i++) {
+        printTaskRow(results[i]);
+    }
+    printf("--------------------------------------------------------------------------------------------------\n");
+    printf("%d of %d tasks match.\n", count, task_count);
+    free(results);
 }
 
-// Helper to convert a "YYYY-MM-DD" string to a time_t object
-time_t stringToTime(const char* date_str) {
-    struct tm tm = {0};
-    if (sscanf(date_str, "%d-%d-%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday) == 3) {
-        tm.tm_year -= 1900; // tm_year is years since 1900
-        tm.tm_mon -= 1;     // tm_mon is 0-11
-        return mktime(&tm);
+// Finds the tasks matching every word of `query`; a word followed by '*'
+// matches any word it begins. Each word becomes a range of sorted_terms.
+// The word with the fewest postings gives the candidates, and every other
+// word only has to confirm them, skipping through its posting lists; a
+// prefix spread over many lists checks the few candidates' descriptions
+// instead.
+// Stores the ascending task indices in a new array in *results (free() it)
+// and returns their number, or -1 if out of memory.
+int searchTasks(const char *query, int **results) {
+    int first[MAX_QUERY_WORDS], last[MAX_QUERY_WORDS], order[MAX_QUERY_WORDS], lengths[MAX_QUERY_WORDS];
+    long long sizes[MAX_QUERY_WORDS];
+    char terms[MAX_QUERY_WORDS][MAX_TERM_LENGTH + 1];
+    int words = 0, length, prefix;
+
+    *results = NULL;
+    if (!sorted_valid) {
+        qsort(sorted_terms, (size_t)term_count, sizeof(int), compareTerms);
+        sorted_valid = 1;
+    }
+    while (words < MAX_QUERY_WORDS && (length = nextTerm(&query, terms[words], &prefix)) > 0) {
+        const char *term = terms[words];
+        int lo = lowerBoundTerm(term), hi = lo;
+        long long size = 0;
+        while (hi < term_count && (prefix ? strncmp(term_text + term_offsets[sorted_terms[hi]], term, (size_t)length)
+                                          : strcmp(term_text + term_offsets[sorted_terms[hi]], term)) == 0) {
+            size += postings[sorted_terms[hi++]].count;
+        }
+        if (size == 0) {
+            return 0;
+        }
+        // Insertion sort by size, smallest first
+        lengths[words] = prefix ? length : -1;
+        int w = words++;
+        for (; w > 0 && sizes[w - 1] > size; w--) {
+            first[w] = first[w - 1];
+            last[w] = last[w - 1];
+            sizes[w] = sizes[w - 1];
+            order[w] = order[w - 1];
+        }
+        first[w] = lo;
+        last[w] = hi;
+        sizes[w] = size;
+        order[w] = words - 1;
+    }
+    if (words == 0) {
+        return 0;
+    }
+
+    // Candidates: the union of the smallest word's lists, in order
+    int room = sizes[0] < task_count ? (int)sizes[0] : task_count;
+    int *found = malloc(((size_t)room + 1) * sizeof(int));
+    unsigned char *matched = malloc((size_t)room + 1);
+    if (found == NULL || matched == NULL) {
+        free(found);
+        free(matched);
+        return -1;
     }
-    return time(NULL); // Return current time on failure
+    int count = 0;
+    if (last[0] - first[0] == 1) {
+        count = readPostings(&postings[sorted_terms[first[0]]], found, NULL);
+    } else {
+        size_t words64 = ((size_t)task_count + 63) / 64;
+        uint64_t *bits = calloc(words64, sizeof(uint64_t));
+        if (bits == NULL) {
+            free(found);
+            free(matched);
+            return -1;
+        }
+        for (int t = first[0]; t < last[0]; t++) {
+            readPostings(&postings[sorted_terms[t]], NULL, bits);
+        }
+        for (size_t i = 0; i < words64; i++) {
+            for (uint64_t word = bits[i]; word != 0; word &= word - 1) {
+                found[count++] = (int)(i * 64) + lowestBit(word);
+            }
+        }
+        free(bits);
+    }
+
+    // Every other word keeps the candidates found on one of its lists
+    for (int w = 1; w < words && count > 0; w++) {
+        memset(matched, 0, (size_t)count);
+        int read_text = last[w] - first[w] > 1 && (long long)count * 16 < sizes[w];
+        for (int i = 0; read_text && i < count; i++) {
+            matched[i] = (unsigned char)taskHasTerm(found[i], terms[order[w]], lengths[order[w]]);
+        }
+        for (int t = first[w]; t < last[w] && !read_text; t++) {
+            // Leapfrog: the list skips to the next candidate, and the
+            // candidates gallop to the next posting
+            PostingCursor cursor = { &postings[sorted_terms[t]], 0, 0, -1 };
+            int i = 0;
+            while (i < count) {
+                int index = advanceCursor(&cursor, found[i]);
+                if (index < 0) {
+                    break;
+                }
+                if (index == found[i]) {
+                    matched[i++] = 1;
+                    continue;
+                }
+                int step = 1;
+                while (i + step < count && found[i + step] < index) {
+                    step *= 2;
+                }
+                int lo = i + step / 2, hi = i + step < count ? i + step : count;
+                while (lo < hi) {
+                    int mid = lo + (hi - lo) / 2;
+                    if (found[mid] < index) {
+                        lo = mid + 1;
+                    } else {
+                        hi = mid;
+                    }
+                }
+                i = lo;
+            }
+        }
+        int kept = 0;
+        for (int i = 0; i < count; i++) {
+            if (matched[i]) {
+                found[kept++] = found[i];
+            }
+        }
+        count = kept;
+    }
+    free(matched);
+    *results = found;
+    return count;
+}
+
+// Reads the next word from *text into `term`, lowercased and cut to
+// MAX_TERM_LENGTH characters, and sets *prefix if a '*' follows it. Bytes
+// from 0x80 up count as letters, so UTF-8 words stay whole. Returns the
+// word's length, or 0 at the end of the text.
+int nextTerm(const char **text, char *term, int *prefix) {
+    const unsigned char *p = (const unsigned char *)*text;
+    int length = 0;
+    while (*p != 0 && !isTermChar(*p)) {
+        p++;
+    }
+    for (; isTermChar(*p); p++) {
+        if (length < MAX_TERM_LENGTH) {
+            term[length++] = (char)(*p >= 'A' && *p <= 'Z' ? *p + 32 : *p);
+        }
+    }
+    term[length] = 0;
+    *prefix = *p == '*';
+    *text = (const char *)p;
+    return length;
+}
+
+// Whether the description of task `index` contains `term`, or with a
+// prefix length other than -1, a word beginning with its first characters
+int taskHasTerm(int index, const char *term, int prefix_length) {
+    const char *text = tasks[index].description;
+    char word[MAX_TERM_LENGTH + 1];
+    int prefix;
+    while (nextTerm(&text, word, &prefix) > 0) {
+        if (prefix_length >= 0 ? strncmp(word, term, (size_t)prefix_length) == 0 : strcmp(word, term) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Whether a byte can be part of a word
+int isTermChar(unsigned char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c >= 0x80;
+}
+
+// Adds the words of task `index` to the index. Tasks must be added in
+// increasing order. Returns 0 if out of memory.
+int indexTask(int index) {
+    const char *text = tasks[index].description;
+    char term[MAX_TERM_LENGTH + 1];
+    int length, prefix;
+    while ((length = nextTerm(&text, term, &prefix)) > 0) {
+        int id = internTerm(term, length);
+        if (id < 0 || !appendPosting(&postings[id], index)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Rebuilds the index over every task; the term order is sorted once at the
+// end rather than kept up as terms arrive. Returns 0 if out of memory.
+int indexAllTasks() {
+    freeSearchIndex();
+    sorted_valid = 0;
+    for (int i = 0; i < task_count; i++) {
+        if (!indexTask(i)) {
+            freeSearchIndex();
+            search_ready = 0;
+            return 0;
+        }
+    }
+    qsort(sorted_terms, (size_t)term_count, sizeof(int), compareTerms);
+    sorted_valid = 1;
+    return 1;
+}
+
+// Returns the id of a term, adding it if it is new, or -1 if out of memory
+int internTerm(const char *term, int length) {
+    if ((term_count + 1) * 2 > term_table_size) {
+        int size = term_table_size ? term_table_size * 2 : 1024;
+        int *table = malloc((size_t)size * sizeof(int));
+        if (table == NULL) {
+            return -1;
+        }
+        memset(table, 0xff, (size_t)size * sizeof(int));
+        free(term_table);
+        term_table = table;
+        term_table_size = size;
+        for (int id = 0; id < term_count; id++) {
+            const char *text = term_text + term_offsets[id];
+            term_table[findTermSlot(text, (int)strlen(text))] = id;
+        }
+    }
+    int slot = findTermSlot(term, length);
+    if (term_table[slot] >= 0) {
+        return term_table[slot];
+    }
+
+    if (term_count == term_capacity) {
+        int grown = term_capacity ? term_capacity * 2 : 1024;
+        int *grown_offsets = realloc(term_offsets, (size_t)grown * sizeof(int));
+        if (grown_offsets != NULL) term_offsets = grown_offsets;
+        PostingList *grown_postings = realloc(postings, (size_t)grown * sizeof(PostingList));
+        if (grown_postings != NULL) postings = grown_postings;
+        int *grown_sorted = realloc(sorted_terms, (size_t)grown * sizeof(int));
+        if (grown_sorted != NULL) sorted_terms = grown_sorted;
+        if (grown_offsets == NULL || grown_postings == NULL || grown_sorted == NULL) {
+            return -1;
+        }
+        term_capacity = grown;
+    }
+    if (term_text_length + length + 1 > term_text_capacity) {
+        int grown = term_text_capacity ? term_text_capacity * 2 : 16384;
+        char *grown_text = realloc(term_text, (size_t)grown);
+        if (grown_text == NULL) {
+            return -1;
+        }
+        term_text = grown_text;
+        term_text_capacity = grown;
+    }
+
+    int id = term_count;
+    term_offsets[id] = term_text_length;
+    memcpy(term_text + term_text_length, term, (size_t)length + 1);
+    term_text_length += length + 1;
+    memset(&postings[id], 0, sizeof(PostingList));
+    postings[id].last = -1;
+    term_table[slot] = id;
+    if (sorted_valid) {
+        int pos = lowerBoundTerm(term);
+        memmove(sorted_terms + pos + 1, sorted_terms + pos, (size_t)(term_count - pos) * sizeof(int));
+        sorted_terms[pos] = id;
+    } else {
+        sorted_terms[id] = id;
+    }
+    term_count++;
+    return id;
+}
+
+// Returns the slot of term_table holding the term, or the empty slot where
+// it belongs
+int findTermSlot(const char *term, int length) {
+    int mask = term_table_size - 1;
+    int slot = (int)(checksumBytes(term, (size_t)length) & (unsigned int)mask);
+    while (term_table[slot] >= 0 && strcmp(term_text + term_offsets[term_table[slot]], term) != 0) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+// Returns the first position in sorted_terms whose term is not less than `term`
+int lowerBoundTerm(const char *term) {
+    int lo = 0, hi = term_count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (strcmp(term_text + term_offsets[sorted_terms[mid]], term) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// qsort() comparison of two term ids by their text
+int compareTerms(const void *a, const void *b) {
+    return strcmp(term_text + term_offsets[*(const int *)a], term_text + term_offsets[*(const int *)b]);
+}
+
+// Adds a task to a posting list, unless it is already the last one there.
+// Returns 0 if out of memory.
+int appendPosting(PostingList *list, int index) {
+    if (list->last == index) {
+        return 1;
+    }
+    if (list->length + 5 > list->capacity) {
+        int grown = list->capacity ? list->capacity * 2 : 16;
+        unsigned char *bytes = realloc(list->bytes, (size_t)grown);
+        if (bytes == NULL) {
+            return 0;
+        }
+        list->bytes = bytes;
+        list->capacity = grown;
+    }
+    if ((list->count + 1) % SKIP_INTERVAL == 0 && list->skip_count == list->skip_capacity) {
+        int grown = list->skip_capacity ? list->skip_capacity * 2 : 4;
+        int *skips = realloc(list->skips, (size_t)grown * 2 * sizeof(int));
+        if (skips == NULL) {
+            return 0;
+        }
+        list->skips = skips;
+        list->skip_capacity = grown;
+    }
+
+    unsigned int gap = (unsigned int)(index - list->last);
+    while (gap >= 0x80) {
+        list->bytes[list->length++] = (unsigned char)(gap | 0x80);
+        gap >>= 7;
+    }
+    list->bytes[list->length++] = (unsigned char)gap;
+    list->last = index;
+    if (++list->count % SKIP_INTERVAL == 0) {
+        list->skips[2 * list->skip_count] = index;
+        list->skips[2 * list->skip_count + 1] = list->length;
+        list->skip_count++;
+    }
+    return 1;
+}
+
+// Decodes a whole posting list into `out`, or sets each task's bit in
+// `bits` instead. Returns the number of postings.
+int readPostings(const PostingList *list, int *out, uint64_t *bits) {
+    const unsigned char *p = list->bytes, *end = list->bytes + list->length;
+    int index = -1, count = 0;
+    while (p < end) {
+        unsigned int gap = *p++;
+        if (gap & 0x80) {
+            gap &= 0x7f;
+            int shift = 7;
+            unsigned char byte;
+            do {
+                byte = *p++;
+                gap |= (unsigned int)(byte & 0x7f) << shift;
+                shift += 7;
+            } while (byte & 0x80);
+        }
+        index += (int)gap;
+        if (bits != NULL) {
+            bits[index >> 6] |= 1ull << (index & 63);
+        } else {
+            out[count] = index;
+        }
+        count++;
+    }
+    return count;
+}
+
+// Moves the cursor to the first posting at or after `target` and returns
+// it, or -1 if there is none. Whole skip intervals below the target are
+// jumped over without decoding.
+int advanceCursor(PostingCursor *cursor, int target) {
+    const PostingList *list = cursor->list;
+    if (cursor->value >= target) {
+        return cursor->value;
+    }
+    for (int skip = cursor->read / SKIP_INTERVAL; skip < list->skip_count && list->skips[2 * skip] < target; skip++) {
+        cursor->value = list->skips[2 * skip];
+        cursor->offset = list->skips[2 * skip + 1];
+        cursor->read = (skip + 1) * SKIP_INTERVAL;
+    }
+    while (cursor->read < list->count) {
+        unsigned int gap = 0;
+        int shift = 0;
+        unsigned char byte;
+        do {
+            byte = list->bytes[cursor->offset++];
+            gap |= (unsigned int)(byte & 0x7f) << shift;
+            shift += 7;
+        } while (byte & 0x80);
+        cursor->value += (int)gap;
+        cursor->read++;
+        if (cursor->value >= target) {
+            return cursor->value;
+        }
+    }
+    return -1;
+}
+
+// Releases the search index
+void freeSearchIndex() {
+    for (int id = 0; id < term_count; id++) {
+        free(postings[id].bytes);
+        free(postings[id].skips);
+    }
+    free(term_text);
+    free(term_offsets);
+    free(postings);
+    free(term_table);
+    free(sorted_terms);
+    term_text = NULL;
+    term_offsets = term_table = sorted_terms = NULL;
+    postings = NULL;
+    term_text_length = term_text_capacity = term_count = term_capacity = term_table_size = 0;
+    sorted_valid = 1;
+}
+
+// Prints the tasks on one timer list (only those due on only_day, unless it
+// is INT32_MIN) and returns how many were printed
+int printTimerList(int list, int32_t only_day) {
+    int printed = 0;
+    for (int node = timer_next[list]; node != list; node = timer_next[node]) {
+        if (only_day == INT32_MIN || tasks[node - LIST_COUNT].due_day == only_day) {
+            printTaskRow(node - LIST_COUNT);
+            printed++;
+        }
+    }
+    return printed;
+}
+
+// Empties the wheel, makes `day` today and files every open task. The next
+// menu banner reports everything that is due or overdue.
+void resetReminders(int32_t day) {
+    for (int list = 0; list < LIST_COUNT; list++) {
+        timer_next[list] = timer_prev[list] = list;
+    }
+    wheel_day = day;
+    for (int i = 0; i < task_count; i++) {
+        timer_prev[LIST_COUNT + i] = -1;
+        if (tasks[i].status != COMPLETED) {
+            timerInsert(i);
+        }
+    }
+    newly_due = timerListLength(LIST_DUE_TODAY);
+    newly_overdue = timerListLength(LIST_OVERDUE);
+}
+
+// Files an open task on the list for its due day
+void timerInsert(int index) {
+    int32_t due = tasks[index].due_day;
+    int list = LIST_OVERFLOW;
+    if (due < wheel_day) {
+        list = LIST_OVERDUE;
+    } else if (due == wheel_day) {
+        list = LIST_DUE_TODAY;
+    } else {
+        for (int level = 0; level < WHEEL_LEVELS; level++) {
+            int shift = WHEEL_BITS * (level + 1);
+            if (due >> shift == wheel_day >> shift) {
+                list = level * WHEEL_SIZE + ((due >> (WHEEL_BITS * level)) & (WHEEL_SIZE - 1));
+                break;
+            }
+        }
+    }
+    timerLink(list, LIST_COUNT + index);
+}
+
+// Takes an entry off whatever list it is on, if any
+void timerRemove(int node) {
+    if (timer_prev[node] < 0) {
+        return;
+    }
+    timer_next[timer_prev[node]] = timer_next[node];
+    timer_prev[timer_next[node]] = timer_prev[node];
+    timer_prev[node] = -1;
+}
+
+// Appends an entry to the end of a list
+void timerLink(int list, int node) {
+    int last = timer_prev[list];
+    timer_next[last] = node;
+    timer_prev[node] = last;
+    timer_next[node] = list;
+    timer_prev[list] = node;
+}
+
+// Moves every entry of one list to the end of another in O(1)
+void timerSplice(int from, int to) {
+    if (timer_next[from] == from) {
+        return;
+    }
+    int first = timer_next[from], last = timer_prev[from], tail = timer_prev[to];
+    timer_next[tail] = first;
+    timer_prev[first] = tail;
+    timer_next[last] = to;
+    timer_prev[to] = last;
+    timer_next[from] = timer_prev[from] = from;
+}
+
+// Number of entries on a list
+int timerListLength(int list) {
+    int length = 0;
+    for (int node = timer_next[list]; node != list; node = timer_next[node]) {
+        length++;
+    }
+    return length;
+}
+
+// Re-files every task on a list against the current day, moving it down the
+// wheel towards its exact day
+void timerCascade(int list) {
+    int node = timer_next[list];
+    timer_next[list] = timer_prev[list] = list;
+    while (node != list) {
+        int next = timer_next[node];
+        timerInsert(node - LIST_COUNT);
+        node = next;
+    }
+}
+
+// Moves the wheel forward one day at a time up to `day`: yesterday's due
+// tasks become overdue, then the slot for the new day becomes due today
+void advanceReminders(int32_t day) {
+    while (wheel_day < day) {
+        newly_overdue += timerListLength(LIST_DUE_TODAY);
+        timerSplice(LIST_DUE_TODAY, LIST_OVERDUE);
+        wheel_day++;
+        // Entering a new block at some level brings its slot down a level
+        if ((wheel_day & (WHEEL_SIZE - 1)) == 0) {
+            for (int level = WHEEL_LEVELS; level >= 1; level--) {
+                int shift = WHEEL_BITS * level;
+                if (level == WHEEL_LEVELS) {
+                    if ((wheel_day & ((1 << shift) - 1)) == 0) {
+                        timerCascade(LIST_OVERFLOW);
+                    }
+                } else if ((wheel_day & ((1 << shift) - 1)) == 0) {
+                    timerCascade(level * WHEEL_SIZE + ((wheel_day >> shift) & (WHEEL_SIZE - 1)));
+                }
+            }
+        }
+        // Cascading may already have filed some of today's tasks directly
+        timerSplice(wheel_day & (WHEEL_SIZE - 1), LIST_DUE_TODAY);
+        newly_due += timerListLength(LIST_DUE_TODAY);
+    }
+}
+
+// Reminder thread body: advances the wheel whenever the local date changes
+THREAD_RETURN reminderLoop(void *arg) {
+    (void)arg;
+    lockMutex(&task_lock);
+    while (reminders_running) {
+        int32_t day = today();
+        if (day > wheel_day) {
+            advanceReminders(day);
+        }
+        unlockMutex(&task_lock);
+        sleepMillis(REMINDER_POLL_MS);
+        lockMutex(&task_lock);
+    }
+    unlockMutex(&task_lock);
+    return THREAD_RESULT;
+}
+
+// Whether task a should be done before task b: in-progress before pending,
+// then higher priority, then earlier due date, then the older task
+int taskBefore(int a, int b) {
+    const Task *x = &tasks[a], *y = &tasks[b];
+    if (x->status != y->status) {
+        return x->status == IN_PROGRESS;
+    }
+    if (x->priority != y->priority) {
+        return x->priority > y->priority;
+    }
+    if (x->due_day != y->due_day) {
+        return x->due_day < y->due_day;
+    }
+    return a < b;
+}
+
+// Swaps two heap entries and updates their recorded positions
+void scheduleSwap(int i, int j) {
+    int held = schedule[i];
+    schedule[i] = schedule[j];
+    schedule[j] = held;
+    schedule_pos[schedule[i]] = i;
+    schedule_pos[schedule[j]] = j;
+}
+
+// Moves a heap entry towards the root while it beats its parent
+void scheduleSiftUp(int pos) {
+    while (pos > 0 && taskBefore(schedule[pos], schedule[(pos - 1) / 2])) {
+        scheduleSwap(pos, (pos - 1) / 2);
+        pos = (pos - 1) / 2;
+    }
+}
+
+// Moves a heap entry towards the leaves while a child beats it
+void scheduleSiftDown(int pos) {
+    for (;;) {
+        int best = pos, left = 2 * pos + 1, right = 2 * pos + 2;
+        if (left < schedule_size && taskBefore(schedule[left], schedule[best])) best = left;
+        if (right < schedule_size && taskBefore(schedule[right], schedule[best])) best = right;
+        if (best == pos) {
+            return;
+        }
+        scheduleSwap(pos, best);
+        pos = best;
+    }
+}
+
+// Brings one task's place in the schedule up to date after it was added or
+// its status changed: completed tasks leave the heap, others enter or move
+void scheduleTask(int index) {
+    int pos = schedule_pos[index];
+    if (tasks[index].status == COMPLETED) {
+        if (pos >= 0) {
+            scheduleSwap(pos, --schedule_size);
+            schedule_pos[index] = -1;
+            if (pos < schedule_size) {
+                scheduleSiftUp(pos);
+                scheduleSiftDown(pos);
+            }
+        }
+        return;
+    }
+    if (pos < 0) {
+        pos = schedule_size++;
+        schedule[pos] = index;
+        schedule_pos[index] = pos;
+    }
+    scheduleSiftUp(pos);
+    scheduleSiftDown(schedule_pos[index]);
+}
+
+// Builds the schedule from scratch in O(n), after loading
+void rebuildSchedule() {
+    schedule_size = 0;
+    for (int i = 0; i < task_count; i++) {
+        schedule_pos[i] = -1;
+        if (tasks[i].status != COMPLETED) {
+            schedule_pos[i] = schedule_size;
+            schedule[schedule_size++] = i;
+        }
+    }
+    for (int pos = schedule_size / 2 - 1; pos >= 0; pos--) {
+        scheduleSiftDown(pos);
+    }
+}
+
+// Saves task data to a binary file. Page 0 of tasks.dat is a header and page
+// p + 1 holds tasks [p * TASKS_PER_PAGE, (p + 1) * TASKS_PER_PAGE); every page
+// starts with a checksum of the rest and its own page number. Once the file
+// exists in this format only the dirty pages are written, through a
+// double-write journal so a crash mid-save cannot leave a torn page.
+void saveDataToFile() {
+    int ok = file_is_paged ? writeDirtyPages() : writeWholeFile();
+    if (!ok) {
+        printf("Error: Could not write %s.\n", FILENAME);
+    }
+    if (dependencies_dirty && !saveDependencies()) {
+        printf("Error: Could not write %s.\n", DEPS_FILENAME);
+    }
+}
+
+// Marks the page holding a task as needing to be written
+void markTaskDirty(int index) {
+    int page = index / TASKS_PER_PAGE;
+    dirty_pages[page / 64] |= (uint64_t)1 << (page % 64);
+}
+
+// Words of dirty_pages needed for `capacity` tasks
+int dirtyWords(int capacity) {
+    return capacity / TASKS_PER_PAGE / 64 + 1;
+}
+
+// Fills `out` with the image of one file page, checksum included
+void buildPage(int page, unsigned char *out) {
+    uint32_t number = (uint32_t)page;
+    memset(out, 0, PAGE_SIZE);
+    memcpy(out + 4, &number, sizeof(number));
+    if (page == 0) {
+        uint32_t fields[4] = {(uint32_t)task_count, PAGE_SIZE, (uint32_t)TASKS_PER_PAGE, (uint32_t)sizeof(Task)};
+        memcpy(out + PAGE_PREFIX, PAGED_MAGIC, 8);
+        memcpy(out + PAGE_PREFIX + 8, fields, sizeof(fields));
+    } else {
+        int first = (page - 1) * TASKS_PER_PAGE;
+        int count = task_count - first < TASKS_PER_PAGE ? task_count - first : TASKS_PER_PAGE;
+        memcpy(out + PAGE_PREFIX, tasks + first, (size_t)count * sizeof(Task));
+    }
+    uint32_t checksum = checksumBytes(out + 4, PAGE_SIZE - 4);
+    memcpy(out, &checksum, sizeof(checksum));
+}
+
+// Whether a page image is intact and is page number page_no (any page if -1)
+int checkPage(const unsigned char *page, int page_no) {
+    uint32_t checksum, number;
+    memcpy(&checksum, page, sizeof(checksum));
+    memcpy(&number, page + 4, sizeof(number));
+    return checksum == checksumBytes(page + 4, PAGE_SIZE - 4) && (page_no < 0 || number == (uint32_t)page_no);
+}
+
+// Writes every page to a temporary file and renames it over tasks.dat, for
+// the first save and after converting an older format. Returns 0 on failure.
+int writeWholeFile() {
+    FILE *file = fopen(TEMP_FILENAME, "wb");
+    if (file == NULL) {
+        return 0;
+    }
+    unsigned char page[PAGE_SIZE];
+    int pages = 1 + (task_count + TASKS_PER_PAGE - 1) / TASKS_PER_PAGE;
+    int ok = 1;
+    for (int p = 0; p < pages && ok; p++) {
+        buildPage(p, page);
+        ok = fwrite(page, PAGE_SIZE, 1, file) == 1;
+    }
+    ok = syncFile(file) && ok;
+    ok = fclose(file) == 0 && ok;
+    if (!ok || !replaceFile(TEMP_FILENAME, FILENAME)) {
+        remove(TEMP_FILENAME);
+        return 0;
+    }
+    memset(dirty_pages, 0, (size_t)dirtyWords(task_capacity) * sizeof(uint64_t));
+    header_dirty = 0;
+    file_is_paged = 1;
+    return 1;
+}
+
+// Writes back the dirty pages: first all of them to the journal, which is
+// forced to disk, then each in place in tasks.dat, then the journal is
+// deleted. If a crash tears a page in place, the next load restores it from
+// the journal. Returns 0 on failure (the pages stay dirty).
+int writeDirtyPages() {
+    int task_pages = (task_count + TASKS_PER_PAGE - 1) / TASKS_PER_PAGE;
+    int count = header_dirty;
+    for (int p = 0; p < task_pages; p++) {
+        count += (int)(dirty_pages[p / 64] >> (p % 64) & 1);
+    }
+    if (count == 0) {
+        return 1;
+    }
+    unsigned char *images = malloc((size_t)count * PAGE_SIZE);
+    int *numbers = malloc((size_t)count * sizeof(int));
+    if (images == NULL || numbers == NULL) {
+        free(images);
+        free(numbers);
+        return 0;
+    }
+    int n = 0;
+    if (header_dirty) {
+        numbers[n] = 0;
+        buildPage(0, images);
+        n++;
+    }
+    for (int p = 0; p < task_pages; p++) {
+        if (dirty_pages[p / 64] >> (p % 64) & 1) {
+            numbers[n] = p + 1;
+            buildPage(p + 1, images + (size_t)n * PAGE_SIZE);
+            n++;
+        }
+    }
+
+    uint32_t journal_count = (uint32_t)count;
+    FILE *journal = fopen(JOURNAL_FILENAME, "wb");
+    int ok = journal != NULL;
+    ok = ok && fwrite(JOURNAL_MAGIC, 8, 1, journal) == 1 && fwrite(&journal_count, sizeof(journal_count), 1, journal) == 1;
+    ok = ok && fwrite(images, PAGE_SIZE, (size_t)count, journal) == (size_t)count && syncFile(journal);
+    if (journal != NULL) {
+        ok = fclose(journal) == 0 && ok;
+    }
+
+    FILE *file = ok ? fopen(FILENAME, "r+b") : NULL;
+    ok = file != NULL;
+    for (int i = 0; i < count && ok; i++) {
+        ok = seekFile(file, (long long)numbers[i] * PAGE_SIZE) &&
+             fwrite(images + (size_t)i * PAGE_SIZE, PAGE_SIZE, 1, file) == 1;
+    }
+    if (file != NULL) {
+        ok = syncFile(file) && ok;
+        ok = fclose(file) == 0 && ok;
+    }
+    free(images);
+    free(numbers);
+    if (!ok) {
+        return 0; // Any journal left behind is replayed on the next load
+    }
+    remove(JOURNAL_FILENAME);
+    memset(dirty_pages, 0, (size_t)dirtyWords(task_capacity) * sizeof(uint64_t));
+    header_dirty = 0;
+    return 1;
+}
+
+// Replays a complete journal left by a save that did not finish, so every
+// page of tasks.dat is whole again. An incomplete journal means the crash
+// came before tasks.dat was touched, and it is discarded. Returns 0 if a
+// complete journal could not be applied.
+int recoverJournal() {
+    FILE *journal = fopen(JOURNAL_FILENAME, "rb");
+    if (journal == NULL) {
+        return 1;
+    }
+    char magic[8];
+    uint32_t count = 0;
+    unsigned char *images = NULL;
+    int complete = fread(magic, 8, 1, journal) == 1 && memcmp(magic, JOURNAL_MAGIC, 8) == 0 &&
+                   fread(&count, sizeof(count), 1, journal) == 1 && count > 0 &&
+                   (images = malloc((size_t)count * PAGE_SIZE)) != NULL &&
+                   fread(images, PAGE_SIZE, count, journal) == count;
+    fclose(journal);
+    for (uint32_t i = 0; complete && i < count; i++) {
+        complete = checkPage(images + (size_t)i * PAGE_SIZE, -1);
+    }
+
+    int ok = 1;
+    if (complete) {
+        FILE *file = fopen(FILENAME, "r+b");
+        ok = file != NULL;
+        for (uint32_t i = 0; i < count && ok; i++) {
+            uint32_t number;
+            memcpy(&number, images + (size_t)i * PAGE_SIZE + 4, sizeof(number));
+            ok = seekFile(file, (long long)number * PAGE_SIZE) &&
+                 fwrite(images + (size_t)i * PAGE_SIZE, PAGE_SIZE, 1, file) == 1;
+        }
+        if (file != NULL) {
+            ok = syncFile(file) && ok;
+            ok = fclose(file) == 0 && ok;
+        }
+        if (ok) {
+            printf("Restored %u pages of %s from %s after an interrupted save.\n", count, FILENAME, JOURNAL_FILENAME);
+        }
+    }
+    free(images);
+    if (ok) {
+        remove(JOURNAL_FILENAME);
+    }
+    return ok;
+}
+
+// Reads a paged tasks.dat, checking every page. Returns the number of tasks,
+// or -1 (after saying why) if the file is damaged.
+int loadPagedTasks(FILE *file, long long size) {
+    unsigned char page[PAGE_SIZE];
+    uint32_t fields[4];
+    if (fread(page, PAGE_SIZE, 1, file) != 1 || !checkPage(page, 0)) {
+        printf("Error: The header of %s is damaged.\n", FILENAME);
+        return -1;
+    }
+    memcpy(fields, page + PAGE_PREFIX + 8, sizeof(fields));
+    int count = (int)fields[0];
+    // Files from before duration_days hold shorter records; they are converted
+    size_t record_size = fields[3];
+    int per_page = (int)fields[2];
+    int pages = per_page > 0 ? 1 + (count + per_page - 1) / per_page : 0;
+    if (count < 0 || fields[1] != PAGE_SIZE || (record_size != sizeof(Task) && record_size != TASK_SIZE_NO_DURATION) ||
+        per_page != (int)((PAGE_SIZE - PAGE_PREFIX) / record_size) || size < (long long)pages * PAGE_SIZE) {
+        printf("Error: %s was written with a different page layout or is truncated.\n", FILENAME);
+        return -1;
+    }
+    if (!reserveTasks(count)) {
+        printf("Error: Not enough memory for %d tasks.\n", count);
+        return -1;
+    }
+    for (int p = 1; p < pages; p++) {
+        if (fread(page, PAGE_SIZE, 1, file) != 1 || !checkPage(page, p)) {
+            printf("Error: Page %d of %s is damaged.\n", p, FILENAME);
+            return -1;
+        }
+        int first = (p - 1) * per_page;
+        int n = count - first < per_page ? count - first : per_page;
+        for (int i = 0; i < n; i++) {
+            memcpy(&tasks[first + i], page + PAGE_PREFIX + (size_t)i * record_size, record_size);
+            if (record_size < sizeof(Task)) {
+                tasks[first + i].duration_days = 1;
+            }
+        }
+    }
+    task_count = count;
+    file_is_paged = record_size == sizeof(Task);
+    return count;
+}
+
+// Loads task data from a binary file
+void loadDataFromFile() {
+    if (!recoverJournal()) {
+        printf("Error: Could not restore %s from %s. Exiting.\n", FILENAME, JOURNAL_FILENAME);
+        exit(1);
+    }
+    FILE *file = fopen(FILENAME, "rb");
+    if (!file) {
+        // File doesn't exist, first run.
+        return;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    char magic[PAGE_PREFIX + 8];
+    int count = 0, converted = 0, loaded;
+    size_t got = fread(magic, 1, sizeof(magic), file);
+    fseek(file, 0, SEEK_SET);
+    if (got == sizeof(magic) && memcmp(magic + PAGE_PREFIX, PAGED_MAGIC, 8) == 0) {
+        loaded = loadPagedTasks(file, size);
+        converted = file_is_paged ? 0 : loaded;
+    } else if (got >= 8 && memcmp(magic, FILE_MAGIC, 8) == 0) {
+        fseek(file, 8, SEEK_SET);
+        loaded = fread(&count, sizeof(int), 1, file) == 1 && count >= 0 && reserveTasks(count);
+        if (loaded) {
+            // Records from before duration_days
+            unsigned char raw[TASK_SIZE_NO_DURATION];
+            task_count = 0;
+            while (task_count < count && fread(raw, sizeof(raw), 1, file) == 1) {
+                memcpy(&tasks[task_count], raw, sizeof(raw));
+                tasks[task_count++].duration_days = 1;
+            }
+            converted = task_count;
+        }
+        loaded = loaded ? task_count : -1;
+    } else {
+        loaded = converted = loadLegacyTasks(file, size);
+    }
+    fclose(file);
+    if (loaded < 0) {
+        // Refuse to run rather than overwrite the file on exit
+        printf("Error: Could not load %s. Please move it aside and restart. Exiting.\n", FILENAME);
+        exit(1);
+    }
+    rebuildSchedule();
+    loadDependencies();
+    if (!indexAllTasks()) {
+        printf("Warning: Not enough memory to index the tasks; search is unavailable.\n");
+    }
+    printf("Task data loaded successfully from %s.\n", FILENAME);
+    if (converted > 0) {
+        printf("Converted %d tasks from an older file format; they will be saved in the new one.\n", converted);
+    }
+    printf("Press Enter to continue...");
+    getchar();
+}
+
+// Reads a tasks.dat written before due dates were day numbers: a count and
+// Task records ending in a time_t of 32 or 64 bits, whichever the writing
+// compiler used. Each due time is converted to its local calendar day.
+// Returns the number of tasks read, or -1 if the file is not in that format.
+int loadLegacyTasks(FILE *file, long size) {
+    int count = 0;
+    if (fread(&count, sizeof(int), 1, file) != 1 || count < 0) {
+        return -1;
+    }
+    long record_size = count > 0 ? (size - 4) / count : 0;
+    if (count > 0 && ((size - 4) % count != 0 ||
+                      (record_size != LEGACY_TASK_SIZE_32 && record_size != LEGACY_TASK_SIZE_64))) {
+        return -1;
+    }
+    if (!reserveTasks(count)) {
+        return -1;
+    }
+
+    unsigned char raw[LEGACY_TASK_SIZE_64];
+    task_count = 0;
+    for (int i = 0; i < count; i++) {
+        if (fread(raw, (size_t)record_size, 1, file) != 1) {
+            break;
+        }
+        Task *task = &tasks[task_count];
+        int priority, status;
+        memcpy(task->description, raw, MAX_DESC_LENGTH);
+        task->description[MAX_DESC_LENGTH - 1] = 0;
+        memcpy(&priority, raw + 152, sizeof(int));
+        memcpy(&status, raw + 156, sizeof(int));
+        task->priority = (priority == HIGH) ? HIGH : (priority == MEDIUM) ? MEDIUM : LOW;
+        task->status = (status == COMPLETED) ? COMPLETED : (status == IN_PROGRESS) ? IN_PROGRESS : PENDING;
+        task->duration_days = 1;
+
+        time_t due;
+        if (record_size == LEGACY_TASK_SIZE_64) {
+            int64_t when;
+            memcpy(&when, raw + 160, sizeof(when));
+            due = (time_t)when;
+        } else {
+            int32_t when;
+            memcpy(&when, raw + 160, sizeof(when));
+            due = (time_t)when;
+        }
+        struct tm *local = localtime(&due);
+        task->due_day = local ? daysFromCivil(local->tm_year + 1900, local->tm_mon + 1, local->tm_mday) : today();
+        task_count++;
+    }
+    return task_count;
+}
+
+// Parses a "YYYY-MM-DD" date (optionally followed by whitespace) into a day
+// number. Returns 0 if the text is not a valid calendar date.
+int parseDate(const char *text, int32_t *day) {
+    static const unsigned char days_in_month[13] = {0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    static const char layout[] = "dddd-dd-dd";
+    unsigned d[8];
+    int digits = 0;
+    // Reading stops at the first mismatch, so short input is never overrun
+    for (int i = 0; i < 10; i++) {
+        unsigned digit = (unsigned)((unsigned char)text[i] - '0');
+        if (layout[i] == '-' ? text[i] != '-' : digit > 9) {
+            return 0;
+        }
+        if (layout[i] == 'd') {
+            d[digits++] = digit;
+        }
+    }
+    if (text[10] != 0 && text[10] != '\n' && text[10] != '\r' && text[10] != ' ') {
+        return 0;
+    }
+
+    int year = (int)(d[0] * 1000 + d[1] * 100 + d[2] * 10 + d[3]);
+    int month = (int)(d[4] * 10 + d[5]);
+    int mday = (int)(d[6] * 10 + d[7]);
+    int leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    if (month < 1 || month > 12 || mday < 1 || mday > days_in_month[month] + (month == 2 && leap)) {
+        return 0;
+    }
+    *day = daysFromCivil(year, month, mday);
+    return 1;
+}
+
+// Writes a day number as "YYYY-MM-DD" plus a NUL and returns the length (10)
+int formatDate(int32_t day, char *out) {
+    int year, month, mday;
+    civilFromDays(day, &year, &month, &mday);
+    if (year < 0 || year > 9999) {
+        year = year < 0 ? 0 : 9999; // Outside what the format can show
+    }
+    out[0] = (char)('0' + year / 1000);
+    out[1] = (char)('0' + year / 100 % 10);
+    out[2] = (char)('0' + year / 10 % 10);
+    out[3] = (char)('0' + year % 10);
+    out[4] = '-';
+    out[5] = (char)('0' + month / 10);
+    out[6] = (char)('0' + month % 10);
+    out[7] = '-';
+    out[8] = (char)('0' + mday / 10);
+    out[9] = (char)('0' + mday % 10);
+    out[10] = 0;
+    return 10;
+}
+
+// Days from 1970-01-01 to a proleptic Gregorian date
+int32_t daysFromCivil(int year, int month, int day) {
+    year -= month <= 2;
+    int era = (year >= 0 ? year : year - 399) / 400;
+    int year_of_era = year - era * 400;
+    int day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    int day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + day_of_era - 719468;
+}
+
+// Proleptic Gregorian date of a day number; the inverse of daysFromCivil()
+void civilFromDays(int32_t days, int *year, int *month, int *day) {
+    days += 719468;
+    int era = (days >= 0 ? days : days - 146096) / 146097;
+    int day_of_era = days - era * 146097;
+    int year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    int day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    int shifted_month = (5 * day_of_year + 2) / 153;
+    *day = day_of_year - (153 * shifted_month + 2) / 5 + 1;
+    *month = shifted_month < 10 ? shifted_month + 3 : shifted_month - 9;
+    *year = year_of_era + era * 400 + (*month <= 2);
+}
+
+// Today's day number in the local calendar
+int32_t today() {
+    time_t now = time(NULL);
+    struct tm local;
+#ifdef _WIN32
+    localtime_s(&local, &now);
+#else
+    localtime_r(&now, &local); // The reminder thread calls this too
+#endif
+    return daysFromCivil(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday);
+}
+
+// Checks parseDate() and formatDate() against sscanf/mktime and
+// localtime/strftime for every day from BENCH_FIRST_YEAR to BENCH_LAST_YEAR,
+// then times both ways. Returns the process exit status.
+int runBenchmark() {
+    int32_t first = daysFromCivil(BENCH_FIRST_YEAR, 1, 1);
+    int32_t last = daysFromCivil(BENCH_LAST_YEAR, 12, 31);
+    int days = last - first + 1;
+    char (*texts)[16] = malloc((size_t)days * sizeof(*texts));
+    if (texts == NULL) {
+        printf("Error: Not enough memory.\n");
+        return 1;
+    }
+
+    // Agreement: the formatter against strftime in UTC, the parser against
+    // mktime + localtime, and a few dates that must be rejected. A day the
+    // local time zone skipped (Samoa lost 2011-12-30) comes back from mktime
+    // as the next day; such days are counted apart.
+    int mismatches = 0, skipped = 0;
+    for (int i = 0; i < days; i++) {
+        char expected[16];
+        time_t noon = (time_t)(first + i) * 86400 + 43200;
+        struct tm *utc = gmtime(&noon);
+        strftime(expected, sizeof(expected), "%Y-%m-%d", utc);
+        formatDate(first + i, texts[i]);
+        int32_t parsed;
+        mismatches += strcmp(texts[i], expected) != 0 || !parseDate(texts[i], &parsed) || parsed != first + i;
+
+        struct tm tm = {0};
+        sscanf(texts[i], "%d-%d-%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday);
+        tm.tm_year -= 1900;
+        tm.tm_mon -= 1;
+        tm.tm_isdst = -1;
+        time_t midnight = mktime(&tm);
+        struct tm *local = midnight == (time_t)-1 ? NULL : localtime(&midnight);
+        if (local != NULL) {
+            skipped += daysFromCivil(local->tm_year + 1900, local->tm_mon + 1, local->tm_mday) != first + i;
+        }
+    }
+    const char *invalid[] = {"2023-02-29", "2100-02-29", "2024-13-01", "2024-00-10", "2024-04-31", "2024-1-01",
+                             "24-01-01", "2024/01/01", "2024-01-0x", "", "2024-01-011"};
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        int32_t parsed;
+        mismatches += parseDate(invalid[i], &parsed);
+    }
+    printf("Checked %d days from %d to %d against the C library: %d mismatches.\n",
+           days, BENCH_FIRST_YEAR, BENCH_LAST_YEAR, mismatches);
+    if (skipped > 0) {
+        printf("(%d of those days do not exist in the local time zone.)\n", skipped);
+    }
+
+    // Speed of each way, over BENCH_PASSES passes of every day
+    volatile long long sink = 0;
+    double start = nowSeconds();
+    for (int pass = 0; pass < BENCH_PASSES; pass++) {
+        for (int i = 0; i < days; i++) {
+            struct tm tm = {0};
+            sscanf(texts[i], "%d-%d-%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday);
+            tm.tm_year -= 1900;
+            tm.tm_mon -= 1;
+            sink += mktime(&tm);
+        }
+    }
+    double libc_parse = nowSeconds() - start;
+    start = nowSeconds();
+    for (int pass = 0; pass < BENCH_PASSES; pass++) {
+        for (int i = 0; i < days; i++) {
+            int32_t parsed;
+            sink += parseDate(texts[i], &parsed) + parsed;
+        }
+    }
+    double fast_parse = nowSeconds() - start;
+    start = nowSeconds();
+    for (int pass = 0; pass < BENCH_PASSES; pass++) {
+        for (int i = 0; i < days; i++) {
+            char out[16];
+            time_t noon = (time_t)(first + i) * 86400 + 43200;
+            strftime(out, sizeof(out), "%Y-%m-%d", localtime(&noon));
+            sink += out[9];
+        }
+    }
+    double libc_format = nowSeconds() - start;
+    start = nowSeconds();
+    for (int pass = 0; pass < BENCH_PASSES; pass++) {
+        for (int i = 0; i < days; i++) {
+            char out[16];
+            formatDate(first + i, out);
+            sink += out[9];
+        }
+    }
+    double fast_format = nowSeconds() - start;
+
+    double total = (double)days * BENCH_PASSES;
+    printf("  %-28s %8.1f M dates/s\n", "Parse, sscanf + mktime:", total / libc_parse / 1e6);
+    printf("  %-28s %8.1f M dates/s  %.1fx\n", "Parse, parseDate:", total / fast_parse / 1e6, libc_parse / fast_parse);
+    printf("  %-28s %8.1f M dates/s\n", "Format, localtime + strftime:", total / libc_format / 1e6);
+    printf("  %-28s %8.1f M dates/s  %.1fx\n", "Format, formatDate:", total / fast_format / 1e6,
+           libc_format / fast_format);
+    free(texts);
+    return (mismatches == 0 && checkLegacyFormats() && runReminderBenchmark() && runPlanBenchmark() &&
+            runSearchBenchmark()) ? 0 : 1;
+}
+
+// Writes a few tasks in each original layout, with a 32-bit and a 64-bit
+// time_t, and checks that loadLegacyTasks() reads them back. Returns 0 on a
+// mismatch.
+int checkLegacyFormats() {
+    struct { char description[MAX_DESC_LENGTH]; int priority; int status; int32_t due_date; } narrow[3];
+    struct { char description[MAX_DESC_LENGTH]; int priority; int status; int64_t due_date; } wide[3];
+    int32_t due_days[3];
+    int failures = sizeof(narrow[0]) != LEGACY_TASK_SIZE_32 || sizeof(wide[0]) != LEGACY_TASK_SIZE_64;
+    memset(narrow, 0, sizeof(narrow));
+    memset(wide, 0, sizeof(wide));
+    for (int i = 0; i < 3; i++) {
+        struct tm tm = {0};
+        tm.tm_year = 2024 - 1900;
+        tm.tm_mon = 2;
+        tm.tm_mday = 15 + 10 * i;
+        tm.tm_hour = 12;
+        tm.tm_isdst = -1;
+        time_t noon = mktime(&tm);
+        due_days[i] = daysFromCivil(2024, 3, 15 + 10 * i);
+        snprintf(narrow[i].description, MAX_DESC_LENGTH, "Legacy task %d", i);
+        memcpy(wide[i].description, narrow[i].description, MAX_DESC_LENGTH);
+        narrow[i].priority = wide[i].priority = i == 0 ? HIGH : LOW;
+        narrow[i].status = wide[i].status = i == 2 ? COMPLETED : PENDING;
+        narrow[i].due_date = (int32_t)noon;
+        wide[i].due_date = (int64_t)noon;
+    }
+
+    for (int layout = 0; layout < 2 && failures == 0; layout++) {
+        FILE *file = tmpfile();
+        int count = 3;
+        if (file == NULL) {
+            printf("Error: Could not create a temporary file.\n");
+            return 0;
+        }
+        fwrite(&count, sizeof(count), 1, file);
+        if (layout == 0) {
+            fwrite(narrow, sizeof(narrow), 1, file);
+        } else {
+            fwrite(wide, sizeof(wide), 1, file);
+        }
+        long size = ftell(file);
+        rewind(file);
+        failures += loadLegacyTasks(file, size) != count;
+        fclose(file);
+        for (int i = 0; i < task_count && i < count; i++) {
+            failures += strcmp(tasks[i].description, narrow[i].description) != 0 ||
+                        tasks[i].priority != (TaskPriority)narrow[i].priority ||
+                        tasks[i].status != (TaskStatus)narrow[i].status || tasks[i].due_day != due_days[i];
+        }
+    }
+    task_count = 0;
+    printf("Read back tasks stored with a 32-bit and a 64-bit time_t: %s.\n", failures == 0 ? "ok" : "MISMATCH");
+    return failures == 0;
+}
+
+// Files BENCH_TASKS tasks with random due days (a few centuries out, to
+// reach every level and the overflow list) in the timer wheel, then advances
+// it day by day and checks that each task falls due on exactly its day.
+// Returns 0 if anything is out of place.
+int runReminderBenchmark() {
+    if (!reserveTasks(BENCH_TASKS)) {
+        printf("Error: Not enough memory.\n");
+        return 0;
+    }
+    int32_t start = daysFromCivil(2024, 1, 1);
+    int32_t last = start;
+    uint64_t seed = 88172645463325252ull;
+    task_count = BENCH_TASKS;
+    for (int i = 0; i < BENCH_TASKS; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        // Mostly the next three years, some up to 800 years ahead, some overdue
+        int32_t offset = (int32_t)(seed % 1100) - 30;
+        if (i % 1000 == 0) {
+            offset = (int32_t)((seed >> 20) % 292000);
+        }
+        memset(&tasks[i], 0, sizeof(Task));
+        tasks[i].status = PENDING;
+        tasks[i].due_day = start + offset;
+        last = tasks[i].due_day > last ? tasks[i].due_day : last;
+    }
+
+    double begin = nowSeconds();
+    resetReminders(start);
+    double filed = nowSeconds() - begin;
+
+    long long fell_due = newly_due, misplaced = 0;
+    long long ticks = 0;
+    double busiest = 0.0;
+    begin = nowSeconds();
+    while (wheel_day < last) {
+        double tick = nowSeconds();
+        int before = newly_due;
+        advanceReminders(wheel_day + 1);
+        tick = nowSeconds() - tick;
+        busiest = tick > busiest ? tick : busiest;
+        fell_due += newly_due - before;
+        for (int node = timer_next[LIST_DUE_TODAY]; node != LIST_DUE_TODAY; node = timer_next[node]) {
+            misplaced += tasks[node - LIST_COUNT].due_day != wheel_day;
+        }
+        ticks++;
+    }
+    double advanced = nowSeconds() - begin;
+
+    // Everything not overdue from the start must have fallen due exactly once
+    long long expected = 0;
+    for (int i = 0; i < BENCH_TASKS; i++) {
+        expected += tasks[i].due_day >= start;
+    }
+    printf("Reminders: %d tasks filed in %.1f ms (%.0f ns each); %lld days advanced in %.1f ms\n",
+           BENCH_TASKS, filed * 1e3, filed * 1e9 / BENCH_TASKS, ticks, advanced * 1e3);
+    printf("  %.2f us per day on average (including the check), slowest day %.2f ms; "
+           "%lld fell due, %lld expected, %lld misplaced.\n",
+           advanced * 1e6 / (double)ticks, busiest * 1e3, fell_due, expected, misplaced);
+    task_count = 0;
+    return fell_due == expected && misplaced == 0;
+}
+
+// Plans BENCH_TASKS tasks with BENCH_EDGES_PER_TASK random prerequisites
+// each, then completes BENCH_COMPLETIONS random tasks one at a time with
+// incremental updates and checks the result against a full rebuild
+int runPlanBenchmark() {
+    task_count = BENCH_TASKS;
+    uint64_t seed = 2463534242ull;
+    for (int i = 0; i < BENCH_TASKS; i++) {
+        tasks[i].status = PENDING;
+        tasks[i].duration_days = 1 + i % 5;
+    }
+    double begin = nowSeconds();
+    for (int t = 1; t < BENCH_TASKS; t++) {
+        for (int k = 0; k < BENCH_EDGES_PER_TASK; k++) {
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            // Mostly nearby prerequisites, so chains are long
+            int span = k == 0 ? 64 : t;
+            int prereq = t - 1 - (int)(seed % (uint64_t)(span < t ? span : t));
+            if (!addDependency(t, prereq)) {
+                printf("Error: Not enough memory.\n");
+                return 0;
+            }
+        }
+    }
+    double added = nowSeconds() - begin;
+    begin = nowSeconds();
+    if (!ensurePlan()) {
+        printf("Error: Not enough memory.\n");
+        return 0;
+    }
+    double built = nowSeconds() - begin;
+
+    begin = nowSeconds();
+    for (int i = 0; i < BENCH_COMPLETIONS; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        int t = (int)(seed % BENCH_TASKS);
+        tasks[t].status = COMPLETED;
+        updatePlan(t);
+    }
+    double updated = nowSeconds() - begin;
+
+    int32_t *start = malloc((size_t)BENCH_TASKS * sizeof(int32_t));
+    int *waves = malloc((size_t)BENCH_TASKS * sizeof(int));
+    long long differences = 0;
+    if (start != NULL && waves != NULL) {
+        memcpy(start, earliest_start, (size_t)BENCH_TASKS * sizeof(int32_t));
+        memcpy(waves, wave, (size_t)BENCH_TASKS * sizeof(int));
+        plan_valid = 0;
+        ensurePlan();
+        for (int t = 0; t < BENCH_TASKS; t++) {
+            differences += start[t] != earliest_start[t] || waves[t] != wave[t];
+        }
+    }
+    int deepest = 0;
+    for (int t = 0; t < BENCH_TASKS; t++) {
+        deepest = wave[t] > deepest ? wave[t] : deepest;
+    }
+    printf("Plan: %d tasks, %d dependencies (%.1f ms to add); CSR, order and plan built in %.1f ms, %d waves\n",
+           BENCH_TASKS, dep_count, added * 1e3, built * 1e3, deepest + 1);
+    printf("  %d completions applied incrementally in %.1f ms (%.1f us each); %lld differences from a rebuild.\n",
+           BENCH_COMPLETIONS, updated * 1e3, updated * 1e6 / BENCH_COMPLETIONS, differences);
+    free(start);
+    free(waves);
+    freePlan();
+    dep_count = 0;
+    task_count = 0;
+    return start != NULL && waves != NULL && differences == 0;
+}
+
+// Indexes BENCH_TASKS descriptions of six words drawn from a skewed
+// vocabulary of made-up words that share prefixes, then times a mix of
+// single-word, two-word and prefix queries. The first BENCH_CHECKED_QUERIES
+// are checked against a scan of every description.
+int runSearchBenchmark() {
+    static const char *syllables[16] = { "ka", "lo", "mi", "ne", "ru", "sa", "ti", "vo",
+                                         "ba", "de", "fi", "go", "hu", "je", "po", "ze" };
+    char (*vocabulary)[MAX_TERM_LENGTH + 1] = malloc((size_t)BENCH_VOCABULARY * sizeof(*vocabulary));
+    char (*queries)[64] = malloc((size_t)BENCH_QUERIES * sizeof(*queries));
+    if (vocabulary == NULL || queries == NULL) {
+        printf("Error: Not enough memory.\n");
+        free(vocabulary);
+        free(queries);
+        return 0;
+    }
+    for (int w = 0; w < BENCH_VOCABULARY; w++) {
+        vocabulary[w][0] = 0;
+        for (int k = w + 16; k > 1; k /= 16) {
+            strcat(vocabulary[w], syllables[k % 16]);
+        }
+    }
+    uint64_t seed = 0x9E3779B97F4A7C15ull;
+    int picks[6];
+    task_count = BENCH_TASKS;
+    for (int i = 0; i < BENCH_TASKS; i++) {
+        // Word ranks skewed towards the start of the vocabulary
+        for (int k = 0; k < 6; k++) {
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            double u = (double)(seed % 1000000) / 1e6;
+            picks[k] = (int)(u * u * BENCH_VOCABULARY);
+        }
+        snprintf(tasks[i].description, MAX_DESC_LENGTH, "%s %s %s, %s %s %s", vocabulary[picks[0]],
+                 vocabulary[picks[1]], vocabulary[picks[2]], vocabulary[picks[3]], vocabulary[picks[4]],
+                 vocabulary[picks[5]]);
+    }
+    for (int q = 0; q < BENCH_QUERIES; q++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        // Any word, and one of the most common
+        const char *a = vocabulary[seed % BENCH_VOCABULARY], *b = vocabulary[(seed >> 32) % 64];
+        switch (q % 4) {
+            case 0: snprintf(queries[q], sizeof(queries[q]), "%s", b); break;
+            case 1: snprintf(queries[q], sizeof(queries[q]), "%s %s", a, b); break;
+            case 2: snprintf(queries[q], sizeof(queries[q]), "%.4s*", b); break;
+            default: snprintf(queries[q], sizeof(queries[q]), "%s %.2s*", a, b); break;
+        }
+    }
+
+    double begin = nowSeconds();
+    int indexed = indexAllTasks();
+    double built = nowSeconds() - begin;
+    if (!indexed) {
+        printf("Error: Not enough memory.\n");
+        free(vocabulary);
+        free(queries);
+        return 0;
+    }
+    size_t bytes = 0;
+    for (int id = 0; id < term_count; id++) {
+        bytes += (size_t)postings[id].length + (size_t)postings[id].skip_count * 2 * sizeof(int);
+    }
+
+    static const char *kinds[4] = { "common word", "any word + common word", "4-letter prefix",
+                                     "any word + 2-letter prefix" };
+    double total[4] = { 0 }, slowest[4] = { 0 };
+    long long matches[4] = { 0 };
+    int wrong = 0, failed = 0;
+    for (int q = 0; q < BENCH_QUERIES; q++) {
+        int *results;
+        begin = nowSeconds();
+        int count = searchTasks(queries[q], &results);
+        double took = nowSeconds() - begin;
+        total[q % 4] += took;
+        slowest[q % 4] = took > slowest[q % 4] ? took : slowest[q % 4];
+        if (count < 0) {
+            failed++;
+            continue;
+        }
+        matches[q % 4] += count;
+        if (q < BENCH_CHECKED_QUERIES) {
+            // Every task whose description has each query word (or a word it begins)
+            char words[MAX_QUERY_WORDS][MAX_TERM_LENGTH + 1];
+            int lengths[MAX_QUERY_WORDS], word_count = 0, prefix;
+            const char *text = queries[q];
+            while (word_count < MAX_QUERY_WORDS &&
+                   (lengths[word_count] = nextTerm(&text, words[word_count], &prefix)) > 0) {
+                if (!prefix) {
+                    lengths[word_count] = -1;
+                }
+                word_count++;
+            }
+            int expected = 0;
+            for (int i = 0; i < BENCH_TASKS; i++) {
+                int found = 0;
+                for (int w = 0; w < word_count; w++) {
+                    found += taskHasTerm(i, words[w], lengths[w]);
+                }
+                if (found == word_count) {
+                    wrong += expected >= count || results[expected] != i;
+                    expected++;
+                }
+            }
+            wrong += expected != count;
+        }
+        free(results);
+    }
+    printf("Search: %d tasks indexed in %.1f ms; %d terms, %.1f MB of postings\n", BENCH_TASKS, built * 1e3,
+           term_count, bytes / 1048576.0);
+    for (int k = 0; k < 4; k++) {
+        printf("  %-28s %8.1f us average, %8.1f us slowest, %8.0f matches\n", kinds[k],
+               total[k] * 1e6 / (BENCH_QUERIES / 4), slowest[k] * 1e6, (double)matches[k] / (BENCH_QUERIES / 4));
+    }
+    printf("  %d of %d queries checked by a scan were wrong.\n", wrong, BENCH_CHECKED_QUERIES);
+    freeSearchIndex();
+    task_count = 0;
+    free(vocabulary);
+    free(queries);
+    return wrong == 0 && failed == 0;
+}
+
+// 32-bit FNV-1a hash, used as the page checksum
+unsigned int checksumBytes(const void *data, size_t length) {
+    const unsigned char *bytes = (const unsigned char *)data;
+    unsigned int hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// Flushes stdio buffers and forces the file's data to disk. Returns 0 on failure.
+int syncFile(FILE *file) {
+    if (fflush(file) != 0) {
+        return 0;
+    }
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+// Seeks to an absolute 64-bit offset. Returns 0 on failure.
+int seekFile(FILE *file, long long offset) {
+#ifdef _WIN32
+    return _fseeki64(file, offset, SEEK_SET) == 0;
+#else
+    return fseeko(file, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+// Renames `from` over `to`, replacing it atomically. Returns 0 on failure.
+int replaceFile(const char *from, const char *to) {
+#ifdef _WIN32
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return rename(from, to) == 0;
+#endif
+}
+
+void initMutex(Mutex *mutex) {
+#ifdef _WIN32
+    InitializeCriticalSection(mutex);
+#else
+    pthread_mutex_init(mutex, NULL);
+#endif
+}
+
+void lockMutex(Mutex *mutex) {
+#ifdef _WIN32
+    EnterCriticalSection(mutex);
+#else
+    pthread_mutex_lock(mutex);
+#endif
+}
+
+void unlockMutex(Mutex *mutex) {
+#ifdef _WIN32
+    LeaveCriticalSection(mutex);
+#else
+    pthread_mutex_unlock(mutex);
+#endif
+}
+
+// Starts a thread running func(arg). Returns 0 on failure.
+int startThread(ThreadHandle *thread, ThreadFunc func, void *arg) {
+#ifdef _WIN32
+    *thread = CreateThread(NULL, 0, func, arg, 0, NULL);
+    return *thread != NULL;
+#else
+    return pthread_create(thread, NULL, func, arg) == 0;
+#endif
+}
+
+// Waits for a thread started with startThread() to finish
+void joinThread(ThreadHandle thread) {
+#ifdef _WIN32
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+#else
+    pthread_join(thread, NULL);
+#endif
+}
+
+void sleepMillis(int ms) {
+#ifdef _WIN32
+    Sleep(ms);
+#else
+    usleep((useconds_t)ms * 1000);
+#endif
+}
+
+// Returns the index of the lowest set bit of a nonzero word
+int lowestBit(uint64_t word) {
+#ifdef _WIN32
+    unsigned long bit;
+    _BitScanForward64(&bit, word);
+    return (int)bit;
+#else
+    return __builtin_ctzll(word);
+#endif
+}
+
+// Monotonic wall-clock time in seconds, for throughput measurements
+double nowSeconds() {
+#ifdef _WIN32
+    LARGE_INTEGER now, freq;
+    QueryPerformanceCounter(&now);
+    QueryPerformanceFrequency(&freq);
+    return (double)now.QuadPart / (double)freq.QuadPart;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+#endif
 }
 
 // Helper to convert priority enum to string
@@ -1,17 +1,181 @@
 #include <stdio.h>
 #include <stdlib.h> // For system("cls")
+#include <string.h>
 #include <math.h>   // For sqrt(), pow()
+#include <time.h>
+#ifdef _WIN32
+#include <windows.h> // For QueryPerformanceCounter()
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define HAVE_AVX2_KERNEL 1 // Built with target("avx2") and chosen at run time
+#endif
 
 #define M_PI 3.14159265358979323846
+#define MAX_EXPRESSION_LENGTH 512
+#define MAX_CODE 256             // Instructions in a compiled expression
+#define MAX_NESTING 200          // Parentheses, signs and powers nested inside each other
+#define MAX_CONSTANTS 64
+#define MAX_VARIABLES 32
+#define MAX_NAME_LENGTH 31
+#define MAX_COLUMNS 256          // Columns a data file may have
+#define MAX_LINE_LENGTH 8192     // Longest line of a CSV data file
+#define BATCH_ROWS 2048          // Rows evaluated together
+#define DATA_MAGIC "MATHCOL1"    // Starts a binary data file, see evaluateFile()
+#define MAX_KERNEL_OPERANDS 3
+#define BENCH_ROWS (1 << 22)
+#define BENCH_PASSES 5
+#define MAX_OUTPUTS 4            // Result columns a batch job may write
+
+// Bytecode instructions. Each is two bytes, the opcode and an argument:
+// the constant or variable number for OP_CONST and OP_VAR, else 0.
+typedef enum {
+    OP_CONST,
+    OP_VAR,
+    OP_NEG,
+    OP_ADD,
+    OP_SUB,
+    OP_MUL,
+    OP_DIV,
+    OP_POW,
+    OP_MIN,
+    OP_MAX,
+    OP_SQRT,
+    OP_ABS,
+    OP_EXP,
+    OP_LOG,
+    OP_LOG10,
+    OP_SIN,
+    OP_COS,
+    OP_TAN,
+    OP_FLOOR,
+    OP_CEIL
+} OpCode;
+
+// An expression compiled to postfix bytecode for a stack machine. Names
+// that are not functions or constants are variables, numbered in order of
+// first use; in batch mode they name columns of the data file.
+typedef struct {
+    unsigned char code[MAX_CODE * 2];
+    int length;                  // Bytes used in code
+    double constants[MAX_CONSTANTS];
+    int constant_count;
+    char variables[MAX_VARIABLES][MAX_NAME_LENGTH + 1];
+    int variable_count;
+    int depth;                   // Deepest the stack gets
+    int kernel;                  // Index in kernel_shapes, or -1 to interpret
+    int operands[MAX_KERNEL_OPERANDS]; // Offsets in code of the kernel's operands
+    char error[96];              // Set if the expression did not compile
+    int error_at;                // Offset of the error in the text
+} Program;
+
+// State of the recursive-descent compiler
+typedef struct {
+    const char *text;
+    const char *pos;
+    Program *program;
+    int depth;                   // Current stack depth
+    int nesting;                 // parseUnary() calls in progress
+} Parser;
+
+// A computation over every row of a data file: it reads the input columns
+// and writes output_count results per row. run() gets a row-major block of
+// rows and stores result k of row i at out[k * BATCH_ROWS + i].
+typedef struct BatchJob {
+    const char (*inputs)[MAX_NAME_LENGTH + 1];
+    int input_count;
+    const char *outputs[MAX_OUTPUTS];
+    int output_count;
+    void (*run)(const struct BatchJob *job, const double *rows, int columns, const int *input_columns, int count,
+                double *scratch, double *out);
+    size_t scratch_size;         // Doubles of scratch space run() needs
+    const Program *program;      // The expression, for evaluateFile()
+} BatchJob;
+
+// Functions an expression can call
+typedef struct {
+    const char *name;
+    OpCode op;
+    int arity;
+} Function;
+
+static const Function functions[] = {
+    { "sqrt", OP_SQRT, 1 }, { "abs", OP_ABS, 1 }, { "exp", OP_EXP, 1 }, { "log", OP_LOG, 1 },
+    { "ln", OP_LOG, 1 }, { "log10", OP_LOG10, 1 }, { "sin", OP_SIN, 1 }, { "cos", OP_COS, 1 },
+    { "tan", OP_TAN, 1 }, { "floor", OP_FLOOR, 1 }, { "ceil", OP_CEIL, 1 }, { "pow", OP_POW, 2 },
+    { "min", OP_MIN, 2 }, { "max", OP_MAX, 2 }
+};
+
 // Function Prototypes
 void performArithmetic();
 void solveQuadratic();
 void calculateArea();
 void calculateFactorial();
+void evaluateOverFile();
+int compileExpression(const char *text, Program *program);
+int parseSum(Parser *parser);
+int parseProduct(Parser *parser);
+int parseUnary(Parser *parser);
+int parsePower(Parser *parser);
+int parsePrimary(Parser *parser);
+int parseName(Parser *parser, char *name);
+void skipSpaces(Parser *parser);
+int emit(Parser *parser, OpCode op, int arg);
+int addConstant(Parser *parser, double value);
+int parseError(Parser *parser, const char *message);
+double applyOp(OpCode op, double a, double b);
+double evaluateScalar(const Program *program, const double *values);
+void runProgram(const Program *program, const double *rows, int columns, const int *var_columns, int count,
+                double *stack, double *out);
+void interpretProgram(const Program *program, const double *rows, int columns, const int *var_columns, int count,
+                      double *stack, double *out);
+void selectKernel(Program *program);
+int runBenchmark();
+int evaluateFile(const Program *program, const char *input_path, const char *output_path);
+void runExpressionJob(const BatchJob *job, const double *rows, int columns, const int *input_columns, int count,
+                      double *scratch, double *out);
+void solveQuadraticFile();
+int solveQuadraticsInFile(const char *input_path, const char *output_path);
+void runQuadraticJob(const BatchJob *job, const double *rows, int columns, const int *input_columns, int count,
+                     double *scratch, double *out);
+void solveQuadratics(const double *a, const double *b, const double *c, int count, double *root1_re,
+                     double *root1_im, double *root2_re, double *root2_im);
+void solveQuadraticsScalar(const double *a, const double *b, const double *c, int count, double *root1_re,
+                           double *root1_im, double *root2_re, double *root2_im);
+void solveQuadraticsAVX2(const double *a, const double *b, const double *c, int count, double *root1_re,
+                         double *root1_im, double *root2_re, double *root2_im);
+int useAVX2();
+int runQuadraticBenchmark();
+int processDataFile(const BatchJob *job, const char *input_path, const char *output_path);
+int processBinaryFile(const BatchJob *job, FILE *input, FILE *output, long long *rows_done);
+int processCsvFile(const BatchJob *job, FILE *input, FILE *output, long long *rows_done, long long *bad_rows);
+int findColumns(const BatchJob *job, char names[][MAX_NAME_LENGTH + 1], int columns, int *input_columns);
+int splitCsvHeader(char *line, char names[][MAX_NAME_LENGTH + 1]);
+void readLine(const char *prompt, char *buffer, int size);
+double nowSeconds();
 void displayMenu();
 void clearInputBuffer();
 
-int main() {
+int main(int argc, char *argv[]) {
+    if (argc > 1) {
+        if (strcmp(argv[1], "--bench") == 0) {
+            return runBenchmark();
+        }
+        if (strcmp(argv[1], "--eval") == 0 && argc == 5) {
+            Program program;
+            if (!compileExpression(argv[2], &program)) {
+                printf("Error: %s at position %d.\n", program.error, program.error_at + 1);
+                return 1;
+            }
+            return evaluateFile(&program, argv[3], argv[4]) ? 0 : 1;
+        }
+        if (strcmp(argv[1], "--quadratics") == 0 && argc == 4) {
+            return solveQuadraticsInFile(argv[2], argv[3]) ? 0 : 1;
+        }
+        printf("Usage: %s [--eval EXPRESSION INPUT OUTPUT | --quadratics INPUT OUTPUT | --bench]\n", argv[0]);
+        return 1;
+    }
+
     int choice;
 
     do {
@@ -40,18 +204,24 @@ int main() {
                 calculateFactorial();
                 break;
             case 5:
+                evaluateOverFile();
+                break;
+            case 6:
+                solveQuadraticFile();
+                break;
+            case 7:
                 printf("Exiting Math Solver. Goodbye!\n");
                 break;
             default:
-                printf("Invalid choice! Please select a valid option (1-5).\n");
+                printf("Invalid choice! Please select a valid option (1-7).\n");
         }
 
-        if (choice != 5) {
+        if (choice != 7) {
             printf("\nPress Enter to return to the menu...");
             getchar();
         }
 
-    } while (choice != 5);
+    } while (choice != 7);
 
     return 0;
 }
@@ -60,56 +230,49 @@ int main() {
 void displayMenu() {
     system("cls");
     printf("\n===== MATH QUESTION SOLVER =====\n");
-    printf("1. Basic Arithmetic (+, -, *, /)\n");
+    printf("1. Evaluate an Expression (+, -, *, /, ^, sqrt, pow, ...)\n");
     printf("2. Solve Quadratic Equation (ax^2 + bx + c = 0)\n");
     printf("3. Calculate Area of a Shape\n");
     printf("4. Calculate Factorial (n!)\n");
-    printf("5. Exit\n");
+    printf("5. Evaluate an Expression over a Data File\n");
+    printf("6. Solve Quadratic Equations from a Data File\n");
+    printf("7. Exit\n");
     printf("================================\n");
     printf("Enter your choice: ");
 }
 
-// Solves basic arithmetic problems
+// Evaluates an arithmetic expression, e.g. 5 * 3 or sqrt(2) * (1 + pow(2, -3))
 void performArithmetic() {
-    double num1, num2, result;
-    char op;
+    char text[MAX_EXPRESSION_LENGTH];
+    Program program;
 
-    printf("--- Basic Arithmetic ---\n");
-    printf("Enter an expression (e.g., 5 * 3): ");
-    if (scanf("%lf %c %lf", &num1, &op, &num2) != 3) {
-        printf("Invalid expression format.\n");
-        clearInputBuffer();
+    printf("--- Evaluate an Expression ---\n");
+    printf("Operators: + - * / ^ and parentheses. Functions: sqrt abs exp log log10 sin cos tan\n");
+    printf("floor ceil pow(x, y) min(x, y) max(x, y). Constants: pi e\n");
+    readLine("Enter an expression (e.g., 5 * 3): ", text, sizeof(text));
+
+    if (!compileExpression(text, &program)) {
+        printf("Error: %s at position %d.\n", program.error, program.error_at + 1);
         return;
     }
-    clearInputBuffer();
-
-    switch (op) {
-        case '+':
-            result = num1 + num2;
-            break;
-        case '-':
-            result = num1 - num2;
-            break;
-        case '*':
-            result = num1 * num2;
-            break;
-        case '/':
-            if (num2 == 0) {
-                printf("Error: Division by zero is not allowed.\n");
-                return;
-            }
-            result = num1 / num2;
-            break;
-        default:
-            printf("Error: Invalid operator '%c'.\n", op);
-            return;
+    if (program.variable_count > 0) {
+        printf("Error: Unknown name '%s'. Names other than functions and constants are data file columns;\n"
+               "use option 5 to evaluate over a file.\n", program.variables[0]);
+        return;
+    }
+    double result = evaluateScalar(&program, NULL);
+    if (isinf(result)) {
+        printf("Error: The result is infinite (division by zero or an overflow).\n");
+    } else if (isnan(result)) {
+        printf("Error: The result is undefined (e.g. the square root or logarithm of a negative number).\n");
+    } else {
+        printf("Result: %s = %.10g\n", text, result);
     }
-    printf("Result: %.2lf %c %.2lf = %.2lf\n", num1, op, num2, result);
 }
 
-// Solves a quadratic equation for its real roots
+// Solves a quadratic equation, giving complex roots as well as real ones
 void solveQuadratic() {
-    double a, b, c, discriminant, root1, root2;
+    double a, b, c, root1, root1_im, root2, root2_im;
 
     printf("--- Quadratic Equation Solver (ax^2 + bx + c = 0) ---\n");
     printf("Enter coefficients a, b, and c: ");
@@ -125,17 +288,13 @@ void solveQuadratic() {
         return;
     }
 
-    discriminant = b * b - 4 * a * c;
-
-    if (discriminant > 0) {
-        root1 = (-b + sqrt(discriminant)) / (2 * a);
-        root2 = (-b - sqrt(discriminant)) / (2 * a);
-        printf("Two distinct real roots exist: %.2lf and %.2lf\n", root1, root2);
-    } else if (discriminant == 0) {
-        root1 = -b / (2 * a);
-        printf("One real root exists: %.2lf\n", root1);
-    } else { // discriminant < 0
-        printf("No real roots exist (roots are complex).\n");
+    solveQuadraticsScalar(&a, &b, &c, 1, &root1, &root1_im, &root2, &root2_im);
+    if (root1_im != 0) {
+        printf("Two complex roots exist: %.10g + %.10gi and %.10g - %.10gi\n", root1, root1_im, root2, -root2_im);
+    } else if (b * b - 4 * a * c == 0) {
+        printf("One real root exists: %.10g\n", root1);
+    } else {
+        printf("Two distinct real roots exist: %.10g and %.10g\n", root1, root2);
     }
 }
 
@@ -204,6 +363,1145 @@ void calculateFactorial() {
     }
 }
 
+// Asks for an expression, a data file and an output file, and evaluates the
+// expression for every row of the data file
+void evaluateOverFile() {
+    char text[MAX_EXPRESSION_LENGTH], input_path[260], output_path[260];
+    Program program;
+
+    printf("--- Evaluate an Expression over a Data File ---\n");
+    printf("A CSV file needs a header line naming its columns; the expression uses those names.\n");
+    printf("The results are written in the same format as the input, one per row.\n");
+    readLine("Enter an expression (e.g., sqrt(x^2 + y^2)): ", text, sizeof(text));
+    if (!compileExpression(text, &program)) {
+        printf("Error: %s at position %d.\n", program.error, program.error_at + 1);
+        return;
+    }
+    readLine("Enter the data file: ", input_path, sizeof(input_path));
+    readLine("Enter the output file: ", output_path, sizeof(output_path));
+    evaluateFile(&program, input_path, output_path);
+}
+
+// Compiles an infix expression to bytecode, folding operations whose
+// operands are all constants, and picks a specialized kernel if the result
+// has a common shape. Returns 0 and sets program->error if the expression
+// is not valid.
+int compileExpression(const char *text, Program *program) {
+    Parser parser = { text, text, program, 0, 0 };
+    memset(program, 0, sizeof(*program));
+    program->kernel = -1;
+    if (!parseSum(&parser)) {
+        return 0;
+    }
+    skipSpaces(&parser);
+    if (*parser.pos != 0) {
+        return parseError(&parser, *parser.pos == ')' ? "Unmatched ')'" : "Expected an operator");
+    }
+    selectKernel(program);
+    return 1;
+}
+
+// sum: product (('+' | '-') product)*
+int parseSum(Parser *parser) {
+    if (!parseProduct(parser)) {
+        return 0;
+    }
+    for (;;) {
+        skipSpaces(parser);
+        char c = *parser->pos;
+        if (c != '+' && c != '-') {
+            return 1;
+        }
+        parser->pos++;
+        if (!parseProduct(parser) || !emit(parser, c == '+' ? OP_ADD : OP_SUB, 0)) {
+            return 0;
+        }
+    }
+}
+
+// product: unary (('*' | '/') unary)*
+int parseProduct(Parser *parser) {
+    if (!parseUnary(parser)) {
+        return 0;
+    }
+    for (;;) {
+        skipSpaces(parser);
+        char c = *parser->pos;
+        if (c != '*' && c != '/') {
+            return 1;
+        }
+        parser->pos++;
+        if (!parseUnary(parser) || !emit(parser, c == '*' ? OP_MUL : OP_DIV, 0)) {
+            return 0;
+        }
+    }
+}
+
+// unary: ('-' | '+') unary | power. Powers bind tighter, so -2^2 is -4.
+int parseUnary(Parser *parser) {
+    // Every recursive path goes through here, so this bounds the C stack
+    if (parser->nesting == MAX_NESTING) {
+        return parseError(parser, "Expression nested too deeply");
+    }
+    parser->nesting++;
+    int ok;
+    skipSpaces(parser);
+    if (*parser->pos == '-') {
+        parser->pos++;
+        ok = parseUnary(parser) && emit(parser, OP_NEG, 0);
+    } else if (*parser->pos == '+') {
+        parser->pos++;
+        ok = parseUnary(parser);
+    } else {
+        ok = parsePower(parser);
+    }
+    parser->nesting--;
+    return ok;
+}
+
+// power: primary ('^' unary)?, so 2^3^2 is 2^9 and 2^-1 is allowed
+int parsePower(Parser *parser) {
+    if (!parsePrimary(parser)) {
+        return 0;
+    }
+    skipSpaces(parser);
+    if (*parser->pos != '^') {
+        return 1;
+    }
+    parser->pos++;
+    return parseUnary(parser) && emit(parser, OP_POW, 0);
+}
+
+// primary: number | '(' sum ')' | constant | variable | function '(' sum (',' sum)* ')'
+int parsePrimary(Parser *parser) {
+    skipSpaces(parser);
+    const char *start = parser->pos;
+    char c = *start;
+
+    if ((c >= '0' && c <= '9') || c == '.') {
+        char *end;
+        double value = strtod(start, &end);
+        if (end == start) {
+            return parseError(parser, "Expected a number");
+        }
+        parser->pos = end;
+        int index = addConstant(parser, value);
+        return index >= 0 && emit(parser, OP_CONST, index);
+    }
+    if (c == '(') {
+        parser->pos++;
+        if (!parseSum(parser)) {
+            return 0;
+        }
+        skipSpaces(parser);
+        if (*parser->pos != ')') {
+            return parseError(parser, "Expected ')'");
+        }
+        parser->pos++;
+        return 1;
+    }
+
+    char name[MAX_NAME_LENGTH + 1];
+    if (!parseName(parser, name)) {
+        return parseError(parser, c == 0 ? "Unexpected end of expression" : "Expected a number, name or '('");
+    }
+    skipSpaces(parser);
+    if (*parser->pos == '(') {
+        for (size_t f = 0; f < sizeof(functions) / sizeof(functions[0]); f++) {
+            if (strcmp(name, functions[f].name) != 0) {
+                continue;
+            }
+            parser->pos++;
+            for (int arg = 0; arg < functions[f].arity; arg++) {
+                if (!parseSum(parser)) {
+                    return 0;
+                }
+                skipSpaces(parser);
+                char expected = arg + 1 < functions[f].arity ? ',' : ')';
+                if (*parser->pos != expected) {
+                    return parseError(parser, expected == ',' ? "Expected ',' (this function takes two arguments)"
+                                                              : "Expected ')'");
+                }
+                parser->pos++;
+            }
+            return emit(parser, functions[f].op, 0);
+        }
+        parser->pos = start;
+        return parseError(parser, "Unknown function");
+    }
+    if (strcmp(name, "pi") == 0 || strcmp(name, "e") == 0) {
+        int index = addConstant(parser, name[0] == 'p' ? M_PI : exp(1.0));
+        return index >= 0 && emit(parser, OP_CONST, index);
+    }
+
+    Program *program = parser->program;
+    int var = 0;
+    while (var < program->variable_count && strcmp(program->variables[var], name) != 0) {
+        var++;
+    }
+    if (var == program->variable_count) {
+        if (var == MAX_VARIABLES) {
+            parser->pos = start;
+            return parseError(parser, "Too many different names");
+        }
+        strcpy(program->variables[program->variable_count++], name);
+    }
+    return emit(parser, OP_VAR, var);
+}
+
+// Reads a name (a letter or '_', then letters, digits or '_') into `name`.
+// Returns 0 if there is none here or it is too long.
+int parseName(Parser *parser, char *name) {
+    const char *p = parser->pos;
+    int length = 0;
+    if (!((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z') || *p == '_')) {
+        return 0;
+    }
+    while ((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z') || (*p >= '0' && *p <= '9') || *p == '_') {
+        if (length == MAX_NAME_LENGTH) {
+            return 0;
+        }
+        name[length++] = *p++;
+    }
+    name[length] = 0;
+    parser->pos = p;
+    return 1;
+}
+
+// Skips spaces and tabs
+void skipSpaces(Parser *parser) {
+    while (*parser->pos == ' ' || *parser->pos == '\t') {
+        parser->pos++;
+    }
+}
+
+// Appends an instruction. An operation on constants is evaluated now and
+// replaced by its result, and a variable squared becomes a multiplication,
+// which is correctly rounded and much cheaper than pow(). Returns 0 if the
+// expression is too long.
+int emit(Parser *parser, OpCode op, int arg) {
+    Program *program = parser->program;
+    unsigned char *code = program->code;
+    int operands = op == OP_CONST || op == OP_VAR ? 0 : (op >= OP_ADD && op <= OP_MAX) ? 2 : 1;
+    int n = program->length;
+
+    if (operands == 1 && n >= 2 && code[n - 2] == OP_CONST) {
+        double *value = &program->constants[code[n - 1]];
+        *value = applyOp(op, *value, 0);
+        return 1;
+    }
+    if (operands == 2 && n >= 4 && code[n - 4] == OP_CONST && code[n - 2] == OP_CONST) {
+        double *value = &program->constants[code[n - 3]];
+        *value = applyOp(op, *value, program->constants[code[n - 1]]);
+        if (code[n - 1] == program->constant_count - 1) {
+            program->constant_count--;
+        }
+        program->length -= 2;
+        parser->depth--;
+        return 1;
+    }
+
+    if (op == OP_POW && n >= 4 && code[n - 4] == OP_VAR && code[n - 2] == OP_CONST &&
+        program->constants[code[n - 1]] == 2) {
+        if (code[n - 1] == program->constant_count - 1) {
+            program->constant_count--;
+        }
+        code[n - 2] = OP_VAR;
+        code[n - 1] = code[n - 3];
+        op = OP_MUL;
+    }
+
+    if (n == (int)sizeof(program->code)) {
+        return parseError(parser, "Expression too long");
+    }
+    code[n] = (unsigned char)op;
+    code[n + 1] = (unsigned char)arg;
+    program->length += 2;
+    parser->depth += operands == 0 ? 1 : 1 - operands;
+    if (parser->depth > program->depth) {
+        program->depth = parser->depth;
+    }
+    return 1;
+}
+
+// Adds a constant to the program. Returns its index, or -1 if there are too many.
+int addConstant(Parser *parser, double value) {
+    Program *program = parser->program;
+    if (program->constant_count == MAX_CONSTANTS) {
+        parseError(parser, "Too many numbers");
+        return -1;
+    }
+    program->constants[program->constant_count] = value;
+    return program->constant_count++;
+}
+
+// Records a compile error at the current position. Returns 0.
+int parseError(Parser *parser, const char *message) {
+    Program *program = parser->program;
+    if (program->error[0] == 0) {
+        snprintf(program->error, sizeof(program->error), "%s", message);
+        program->error_at = (int)(parser->pos - parser->text);
+    }
+    return 0;
+}
+
+// Applies an operation to one or two values (b is unused by unary operations)
+double applyOp(OpCode op, double a, double b) {
+    switch (op) {
+        case OP_NEG: return -a;
+        case OP_ADD: return a + b;
+        case OP_SUB: return a - b;
+        case OP_MUL: return a * b;
+        case OP_DIV: return a / b;
+        case OP_POW: return pow(a, b);
+        case OP_MIN: return a < b ? a : b;
+        case OP_MAX: return a > b ? a : b;
+        case OP_SQRT: return sqrt(a);
+        case OP_ABS: return fabs(a);
+        case OP_EXP: return exp(a);
+        case OP_LOG: return log(a);
+        case OP_LOG10: return log10(a);
+        case OP_SIN: return sin(a);
+        case OP_COS: return cos(a);
+        case OP_TAN: return tan(a);
+        case OP_FLOOR: return floor(a);
+        case OP_CEIL: return ceil(a);
+        default: return NAN;
+    }
+}
+
+// Evaluates a program once, with values[i] for variable i
+double evaluateScalar(const Program *program, const double *values) {
+    double stack[MAX_CODE];
+    int sp = 0;
+    for (int pc = 0; pc < program->length; pc += 2) {
+        OpCode op = (OpCode)program->code[pc];
+        int arg = program->code[pc + 1];
+        if (op == OP_CONST) {
+            stack[sp++] = program->constants[arg];
+        } else if (op == OP_VAR) {
+            stack[sp++] = values[arg];
+        } else if (op >= OP_ADD && op <= OP_MAX) {
+            sp--;
+            stack[sp - 1] = applyOp(op, stack[sp - 1], stack[sp]);
+        } else {
+            stack[sp - 1] = applyOp(op, stack[sp - 1], 0);
+        }
+    }
+    return stack[0];
+}
+
+// Specialized kernels: one fused loop per common expression shape, so the
+// rows are read once and nothing is dispatched per instruction. P, Q and R
+// are the operands, each read as values[i * stride].
+typedef void (*Kernel)(const double *p, size_t p_stride, const double *q, size_t q_stride, const double *r,
+                       size_t r_stride, int count, double *out);
+
+#define DEFINE_KERNEL(name, result)                                                                        \
+    void name(const double *p, size_t p_stride, const double *q, size_t q_stride, const double *r,        \
+              size_t r_stride, int count, double *out) {                                                  \
+        for (int i = 0; i < count; i++) {                                                                 \
+            double P = p[i * p_stride], Q = q[i * q_stride], R = r[i * r_stride];                         \
+            (void)R;                                                                                      \
+            out[i] = (result);                                                                            \
+        }                                                                                                 \
+    }
+
+DEFINE_KERNEL(kernelAdd, P + Q)
+DEFINE_KERNEL(kernelSub, P - Q)
+DEFINE_KERNEL(kernelMul, P * Q)
+DEFINE_KERNEL(kernelDiv, P / Q)
+DEFINE_KERNEL(kernelMulAdd, P * Q + R)
+DEFINE_KERNEL(kernelMulSub, P * Q - R)
+DEFINE_KERNEL(kernelSubMul, R - P * Q)
+DEFINE_KERNEL(kernelAddMul, (P + Q) * R)
+DEFINE_KERNEL(kernelAddDiv, (P + Q) / R)
+DEFINE_KERNEL(kernelSubDiv, (P - Q) / R)
+
+#define OP_LEAF 0xff // In a shape: a constant or a variable
+
+// The bytecode a kernel replaces. operands[j] is the kernel operand (0 for
+// P, 1 for Q, 2 for R) that the j-th leaf becomes; addition and
+// multiplication commute exactly, so b + a*x reuses the a*x + b kernel.
+typedef struct {
+    const char *name;
+    unsigned char code[8];
+    int length;
+    int operands[MAX_KERNEL_OPERANDS];
+    Kernel kernel;
+} KernelShape;
+
+static const KernelShape kernel_shapes[] = {
+    { "p + q", { OP_LEAF, OP_LEAF, OP_ADD }, 3, { 0, 1, 2 }, kernelAdd },
+    { "p - q", { OP_LEAF, OP_LEAF, OP_SUB }, 3, { 0, 1, 2 }, kernelSub },
+    { "p * q", { OP_LEAF, OP_LEAF, OP_MUL }, 3, { 0, 1, 2 }, kernelMul },
+    { "p / q", { OP_LEAF, OP_LEAF, OP_DIV }, 3, { 0, 1, 2 }, kernelDiv },
+    { "p * q + r", { OP_LEAF, OP_LEAF, OP_MUL, OP_LEAF, OP_ADD }, 5, { 0, 1, 2 }, kernelMulAdd },
+    { "r + p * q", { OP_LEAF, OP_LEAF, OP_LEAF, OP_MUL, OP_ADD }, 5, { 2, 0, 1 }, kernelMulAdd },
+    { "p * q - r", { OP_LEAF, OP_LEAF, OP_MUL, OP_LEAF, OP_SUB }, 5, { 0, 1, 2 }, kernelMulSub },
+    { "r - p * q", { OP_LEAF, OP_LEAF, OP_LEAF, OP_MUL, OP_SUB }, 5, { 2, 0, 1 }, kernelSubMul },
+    { "(p + q) * r", { OP_LEAF, OP_LEAF, OP_ADD, OP_LEAF, OP_MUL }, 5, { 0, 1, 2 }, kernelAddMul },
+    { "r * (p + q)", { OP_LEAF, OP_LEAF, OP_LEAF, OP_ADD, OP_MUL }, 5, { 2, 0, 1 }, kernelAddMul },
+    { "(p + q) / r", { OP_LEAF, OP_LEAF, OP_ADD, OP_LEAF, OP_DIV }, 5, { 0, 1, 2 }, kernelAddDiv },
+    { "(p - q) / r", { OP_LEAF, OP_LEAF, OP_SUB, OP_LEAF, OP_DIV }, 5, { 0, 1, 2 }, kernelSubDiv }
+};
+
+// Evaluates a program over `count` rows (at most BATCH_ROWS) of a row-major
+// block with `columns` values per row; variable i is column var_columns[i].
+// A program with a specialized kernel runs as one fused loop; any other is
+// interpreted. `stack` must hold program->depth * BATCH_ROWS values.
+void runProgram(const Program *program, const double *rows, int columns, const int *var_columns, int count,
+                double *stack, double *out) {
+    if (program->kernel < 0) {
+        interpretProgram(program, rows, columns, var_columns, count, stack, out);
+        return;
+    }
+    // An operand is a column, or a constant read with a stride of 0
+    const double *values[MAX_KERNEL_OPERANDS];
+    size_t strides[MAX_KERNEL_OPERANDS];
+    for (int k = 0; k < MAX_KERNEL_OPERANDS; k++) {
+        const unsigned char *leaf = program->code + program->operands[k];
+        int constant = leaf[0] == OP_CONST;
+        values[k] = constant ? &program->constants[leaf[1]] : rows + var_columns[leaf[1]];
+        strides[k] = constant ? 0 : (size_t)columns;
+    }
+    kernel_shapes[program->kernel].kernel(values[0], strides[0], values[1], strides[1], values[2], strides[2],
+                                          count, out);
+}
+
+// Evaluates a program over a block like runProgram(), instruction by
+// instruction. Each stack entry is a vector of BATCH_ROWS values, so an
+// instruction is decoded once per block and applied by a tight loop over
+// all its rows.
+void interpretProgram(const Program *program, const double *rows, int columns, const int *var_columns, int count,
+                      double *stack, double *out) {
+    int sp = 0;
+    for (int pc = 0; pc < program->length; pc += 2) {
+        OpCode op = (OpCode)program->code[pc];
+        int arg = program->code[pc + 1];
+        double *b = stack + (size_t)sp * BATCH_ROWS;  // The next entry to push
+        double *a = sp > 0 ? b - BATCH_ROWS : stack;  // The top of the stack
+        switch (op) {
+            case OP_CONST: {
+                double value = program->constants[arg];
+                for (int i = 0; i < count; i++) b[i] = value;
+                sp++;
+                break;
+            }
+            case OP_VAR: {
+                const double *column = rows + var_columns[arg];
+                if (columns == 1) {
+                    memcpy(b, column, (size_t)count * sizeof(double));
+                } else {
+                    for (int i = 0; i < count; i++) b[i] = column[(size_t)i * columns];
+                }
+                sp++;
+                break;
+            }
+            case OP_NEG: for (int i = 0; i < count; i++) a[i] = -a[i]; break;
+            case OP_SQRT: for (int i = 0; i < count; i++) a[i] = sqrt(a[i]); break;
+            case OP_ABS: for (int i = 0; i < count; i++) a[i] = fabs(a[i]); break;
+            case OP_FLOOR: for (int i = 0; i < count; i++) a[i] = floor(a[i]); break;
+            case OP_CEIL: for (int i = 0; i < count; i++) a[i] = ceil(a[i]); break;
+            case OP_EXP: case OP_LOG: case OP_LOG10: case OP_SIN: case OP_COS: case OP_TAN:
+                for (int i = 0; i < count; i++) a[i] = applyOp(op, a[i], 0);
+                break;
+            default: {
+                // Binary: the two top entries are a - BATCH_ROWS and a
+                double *x = a - BATCH_ROWS;
+                switch (op) {
+                    case OP_ADD: for (int i = 0; i < count; i++) x[i] += a[i]; break;
+                    case OP_SUB: for (int i = 0; i < count; i++) x[i] -= a[i]; break;
+                    case OP_MUL: for (int i = 0; i < count; i++) x[i] *= a[i]; break;
+                    case OP_DIV: for (int i = 0; i < count; i++) x[i] /= a[i]; break;
+                    case OP_MIN: for (int i = 0; i < count; i++) x[i] = a[i] < x[i] ? a[i] : x[i]; break;
+                    case OP_MAX: for (int i = 0; i < count; i++) x[i] = a[i] > x[i] ? a[i] : x[i]; break;
+                    default: for (int i = 0; i < count; i++) x[i] = pow(x[i], a[i]); break;
+                }
+                sp--;
+            }
+        }
+    }
+    memcpy(out, stack, (size_t)count * sizeof(double));
+}
+
+// Picks the kernel whose shape matches the whole program, if any. Leaves
+// are constants or variables, and are bound to the kernel's operands in
+// the order the shape lists them.
+void selectKernel(Program *program) {
+    int count = program->length / 2;
+    for (size_t k = 0; k < sizeof(kernel_shapes) / sizeof(kernel_shapes[0]); k++) {
+        const KernelShape *shape = &kernel_shapes[k];
+        int leaves = 0, matched = shape->length == count;
+        for (int i = 0; matched && i < count; i++) {
+            int op = program->code[2 * i];
+            if (shape->code[i] == OP_LEAF) {
+                matched = op == OP_CONST || op == OP_VAR;
+                program->operands[shape->operands[leaves++]] = 2 * i;
+            } else {
+                matched = op == shape->code[i];
+            }
+        }
+        if (matched) {
+            // Unused operands repeat the first one
+            for (int unused = leaves; unused < MAX_KERNEL_OPERANDS; unused++) {
+                program->operands[unused] = program->operands[0];
+            }
+            program->kernel = (int)k;
+            return;
+        }
+    }
+}
+
+// Evaluates a compiled expression for every row of a data file and writes
+// one result per row, in a column named "result". Returns 0 on failure.
+int evaluateFile(const Program *program, const char *input_path, const char *output_path) {
+    BatchJob job = { program->variables, program->variable_count, { "result" }, 1, runExpressionJob,
+                     ((size_t)program->depth + 1) * BATCH_ROWS, program };
+    if (!processDataFile(&job, input_path, output_path)) {
+        return 0;
+    }
+    if (program->kernel >= 0) {
+        printf("The expression ran as the specialized kernel for %s.\n", kernel_shapes[program->kernel].name);
+    }
+    return 1;
+}
+
+// BatchJob.run for evaluateFile()
+void runExpressionJob(const BatchJob *job, const double *rows, int columns, const int *input_columns, int count,
+                      double *scratch, double *out) {
+    runProgram(job->program, rows, columns, input_columns, count, scratch, out);
+}
+
+// Asks for a data file of coefficients and an output file, and solves
+// every equation in it
+void solveQuadraticFile() {
+    char input_path[260], output_path[260];
+    printf("--- Solve Quadratic Equations from a Data File ---\n");
+    printf("The data file needs columns a, b and c; each row is the equation ax^2 + bx + c = 0.\n");
+    printf("The output has columns root1_re, root1_im, root2_re and root2_im, in the input's format.\n");
+    readLine("Enter the data file: ", input_path, sizeof(input_path));
+    readLine("Enter the output file: ", output_path, sizeof(output_path));
+    solveQuadraticsInFile(input_path, output_path);
+}
+
+// Solves the equation in every row of a data file. Returns 0 on failure.
+int solveQuadraticsInFile(const char *input_path, const char *output_path) {
+    static const char inputs[3][MAX_NAME_LENGTH + 1] = { "a", "b", "c" };
+    BatchJob job = { inputs, 3, { "root1_re", "root1_im", "root2_re", "root2_im" }, 4, runQuadraticJob,
+                     3 * (size_t)BATCH_ROWS, NULL };
+    if (!processDataFile(&job, input_path, output_path)) {
+        return 0;
+    }
+    printf("Solved with the %s kernel. A row with a = 0 has the linear equation's root as root 2.\n",
+           useAVX2() ? "AVX2" : "scalar");
+    return 1;
+}
+
+// BatchJob.run for quadratics: gathers the coefficient columns and solves
+// them straight into the four result columns
+void runQuadraticJob(const BatchJob *job, const double *rows, int columns, const int *input_columns, int count,
+                     double *scratch, double *out) {
+    (void)job;
+    for (int k = 0; k < 3; k++) {
+        double *column = scratch + (size_t)k * BATCH_ROWS;
+        for (int i = 0; i < count; i++) {
+            column[i] = rows[(size_t)i * columns + input_columns[k]];
+        }
+    }
+    solveQuadratics(scratch, scratch + BATCH_ROWS, scratch + 2 * BATCH_ROWS, count, out, out + BATCH_ROWS,
+                    out + 2 * BATCH_ROWS, out + 3 * BATCH_ROWS);
+}
+
+// Solves count equations a[i] x^2 + b[i] x + c[i] = 0, with AVX2 where the
+// CPU has it
+void solveQuadratics(const double *a, const double *b, const double *c, int count, double *root1_re,
+                     double *root1_im, double *root2_re, double *root2_im) {
+    if (useAVX2()) {
+        solveQuadraticsAVX2(a, b, c, count, root1_re, root1_im, root2_re, root2_im);
+    } else {
+        solveQuadraticsScalar(a, b, c, count, root1_re, root1_im, root2_re, root2_im);
+    }
+}
+
+// Solves equations one at a time with the citardauq form, which never
+// subtracts nearly equal numbers: q = -(b + sign(b) sqrt(d)) / 2 gives
+// roots q/a and c/q. Complex roots are -b/2a +- i sqrt(-d)/2|a|. Either
+// way there is one square root per equation. With a = 0, root 2 is the
+// linear equation's root -c/b and root 1 is infinite.
+void solveQuadraticsScalar(const double *a, const double *b, const double *c, int count, double *root1_re,
+                           double *root1_im, double *root2_re, double *root2_im) {
+    for (int i = 0; i < count; i++) {
+        double d = b[i] * b[i] - 4 * a[i] * c[i];
+        double s = sqrt(fabs(d));
+        if (d >= 0) {
+            double q = -0.5 * (b[i] + copysign(s, b[i]));
+            root1_re[i] = q / a[i];
+            root2_re[i] = q == 0 ? root1_re[i] : c[i] / q; // b = c = 0: both roots are 0
+            root1_im[i] = root2_im[i] = 0;
+        } else {
+            root1_re[i] = root2_re[i] = -0.5 * b[i] / a[i];
+            root1_im[i] = 0.5 * s / fabs(a[i]);
+            root2_im[i] = -root1_im[i];
+        }
+    }
+}
+
+#ifdef HAVE_AVX2_KERNEL
+// AVX2 version of solveQuadraticsScalar(), with the same operations four
+// equations at a time: both kinds of roots are worked out and blended by
+// the sign of d, and each root is one division, of q or -b/2 by a and of
+// c by q or sqrt(-d)/2 by |a|
+__attribute__((target("avx2")))
+void solveQuadraticsAVX2(const double *a, const double *b, const double *c, int count, double *root1_re,
+                         double *root1_im, double *root2_re, double *root2_im) {
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m256d minus_half = _mm256_set1_pd(-0.5);
+    const __m256d four = _mm256_set1_pd(4.0);
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d va = _mm256_loadu_pd(a + i);
+        __m256d vb = _mm256_loadu_pd(b + i);
+        __m256d vc = _mm256_loadu_pd(c + i);
+        __m256d d = _mm256_sub_pd(_mm256_mul_pd(vb, vb), _mm256_mul_pd(_mm256_mul_pd(four, va), vc));
+        __m256d s = _mm256_sqrt_pd(_mm256_andnot_pd(sign, d));
+        __m256d real = _mm256_cmp_pd(d, zero, _CMP_GE_OQ);
+        __m256d q = _mm256_mul_pd(minus_half, _mm256_add_pd(vb, _mm256_or_pd(s, _mm256_and_pd(sign, vb))));
+        __m256d x1 = _mm256_div_pd(_mm256_blendv_pd(_mm256_mul_pd(minus_half, vb), q, real), va);
+        __m256d x2 = _mm256_div_pd(_mm256_blendv_pd(_mm256_mul_pd(half, s), vc, real),
+                                   _mm256_blendv_pd(_mm256_andnot_pd(sign, va), q, real));
+        x2 = _mm256_blendv_pd(x2, x1, _mm256_and_pd(real, _mm256_cmp_pd(q, zero, _CMP_EQ_OQ)));
+        _mm256_storeu_pd(root1_re + i, x1);
+        _mm256_storeu_pd(root1_im + i, _mm256_andnot_pd(real, x2));
+        _mm256_storeu_pd(root2_re + i, _mm256_blendv_pd(x1, x2, real));
+        _mm256_storeu_pd(root2_im + i, _mm256_andnot_pd(real, _mm256_xor_pd(x2, sign)));
+    }
+    solveQuadraticsScalar(a + i, b + i, c + i, count - i, root1_re + i, root1_im + i, root2_re + i, root2_im + i);
+}
+
+// Whether this CPU can run solveQuadraticsAVX2(); checked once
+int useAVX2() {
+    static int supported = -1;
+    if (supported < 0) {
+        __builtin_cpu_init();
+        supported = __builtin_cpu_supports("avx2") ? 1 : 0;
+    }
+    return supported;
+}
+#else
+void solveQuadraticsAVX2(const double *a, const double *b, const double *c, int count, double *root1_re,
+                         double *root1_im, double *root2_re, double *root2_im) {
+    solveQuadraticsScalar(a, b, c, count, root1_re, root1_im, root2_re, root2_im);
+}
+
+int useAVX2() {
+    return 0;
+}
+#endif
+
+// Runs a batch job over every row of a data file and writes its results.
+// A binary data file is DATA_MAGIC, the column count and a zero as 32-bit
+// integers, the row count as a 64-bit integer, a 32-byte NUL-padded name
+// per column, then the rows as native doubles; the output is the same with
+// the job's result columns. Anything else is read as CSV with a header line
+// of column names, and the output is CSV too, with "nan" results for rows
+// that had a value that is not a number. Returns 0 on failure.
+int processDataFile(const BatchJob *job, const char *input_path, const char *output_path) {
+    FILE *input = fopen(input_path, "rb");
+    if (input == NULL) {
+        printf("Error: Could not open %s.\n", input_path);
+        return 0;
+    }
+    char magic[8];
+    int binary = fread(magic, 1, 8, input) == 8 && memcmp(magic, DATA_MAGIC, 8) == 0;
+    fseek(input, binary ? 8 : 0, SEEK_SET);
+    FILE *output = fopen(output_path, binary ? "wb" : "w");
+    if (output == NULL) {
+        printf("Error: Could not create %s.\n", output_path);
+        fclose(input);
+        return 0;
+    }
+
+    long long rows = 0, bad_rows = 0;
+    double start = nowSeconds();
+    int ok = binary ? processBinaryFile(job, input, output, &rows)
+                    : processCsvFile(job, input, output, &rows, &bad_rows);
+    double seconds = nowSeconds() - start;
+    ok = fclose(output) == 0 && ok;
+    fclose(input);
+    if (!ok) {
+        remove(output_path);
+        return 0;
+    }
+    printf("Processed %lld rows in %.3f s (%.1f M rows/s); results written to %s.\n", rows, seconds,
+           seconds > 0 ? rows / seconds / 1e6 : 0.0, output_path);
+    if (bad_rows > 0) {
+        printf("%lld rows had a value that is not a number; their results are nan.\n", bad_rows);
+    }
+    return 1;
+}
+
+// Runs a job over a binary data file, positioned after its magic. Returns 0 on failure.
+int processBinaryFile(const BatchJob *job, FILE *input, FILE *output, long long *rows_done) {
+    unsigned int header[2];
+    long long rows;
+    char names[MAX_COLUMNS][MAX_NAME_LENGTH + 1];
+    if (fread(header, sizeof(header), 1, input) != 1 || fread(&rows, sizeof(rows), 1, input) != 1 ||
+        header[0] < 1 || header[0] > MAX_COLUMNS || rows < 0) {
+        printf("Error: The data file's header is damaged.\n");
+        return 0;
+    }
+    int columns = (int)header[0];
+    for (int c = 0; c < columns; c++) {
+        if (fread(names[c], MAX_NAME_LENGTH + 1, 1, input) != 1) {
+            printf("Error: The data file's header is damaged.\n");
+            return 0;
+        }
+        names[c][MAX_NAME_LENGTH] = 0;
+    }
+    int input_columns[MAX_VARIABLES];
+    if (!findColumns(job, names, columns, input_columns)) {
+        return 0;
+    }
+
+    unsigned int out_header[2] = { (unsigned int)job->output_count, 0 };
+    int ok = fwrite(DATA_MAGIC, 8, 1, output) == 1 && fwrite(out_header, sizeof(out_header), 1, output) == 1 &&
+             fwrite(&rows, sizeof(rows), 1, output) == 1;
+    for (int k = 0; ok && k < job->output_count; k++) {
+        char out_name[MAX_NAME_LENGTH + 1] = { 0 };
+        strncpy(out_name, job->outputs[k], MAX_NAME_LENGTH);
+        ok = fwrite(out_name, sizeof(out_name), 1, output) == 1;
+    }
+    if (!ok) {
+        printf("Error: Could not write the output file.\n");
+        return 0;
+    }
+
+    double *block = malloc((size_t)BATCH_ROWS * columns * sizeof(double));
+    double *scratch = malloc((job->scratch_size + 1) * sizeof(double));
+    double *out = malloc((size_t)BATCH_ROWS * job->output_count * sizeof(double));
+    double *out_rows = malloc((size_t)BATCH_ROWS * job->output_count * sizeof(double));
+    ok = block != NULL && scratch != NULL && out != NULL && out_rows != NULL;
+    if (!ok) {
+        printf("Error: Not enough memory.\n");
+    }
+    for (long long done = 0; ok && done < rows;) {
+        int count = rows - done < BATCH_ROWS ? (int)(rows - done) : BATCH_ROWS;
+        if (fread(block, (size_t)columns * sizeof(double), (size_t)count, input) != (size_t)count) {
+            printf("Error: The data file ends after %lld of its %lld rows.\n", done, rows);
+            ok = 0;
+            break;
+        }
+        job->run(job, block, columns, input_columns, count, scratch, out);
+        // Results come back a column at a time; the file has them a row at a time
+        const double *results = out;
+        if (job->output_count > 1) {
+            for (int i = 0; i < count; i++) {
+                for (int k = 0; k < job->output_count; k++) {
+                    out_rows[(size_t)i * job->output_count + k] = out[(size_t)k * BATCH_ROWS + i];
+                }
+            }
+            results = out_rows;
+        }
+        size_t values = (size_t)count * job->output_count;
+        if (fwrite(results, sizeof(double), values, output) != values) {
+            printf("Error: Could not write the output file.\n");
+            ok = 0;
+        }
+        done += count;
+        *rows_done = done;
+    }
+    free(block);
+    free(scratch);
+    free(out);
+    free(out_rows);
+    return ok;
+}
+
+// Runs a job over a CSV data file. Returns 0 on failure.
+int processCsvFile(const BatchJob *job, FILE *input, FILE *output, long long *rows_done, long long *bad_rows) {
+    static char line[MAX_LINE_LENGTH];
+    static char names[MAX_COLUMNS][MAX_NAME_LENGTH + 1];
+    if (fgets(line, sizeof(line), input) == NULL) {
+        printf("Error: The data file is empty.\n");
+        return 0;
+    }
+    if (strchr(line, '\n') == NULL && !feof(input)) {
+        printf("Error: The header line is longer than %d characters.\n", MAX_LINE_LENGTH - 2);
+        return 0;
+    }
+    int columns = splitCsvHeader(line, names);
+    if (columns < 0) {
+        printf("Error: The header line must name at most %d columns.\n", MAX_COLUMNS);
+        return 0;
+    }
+    int input_columns[MAX_VARIABLES];
+    if (!findColumns(job, names, columns, input_columns)) {
+        return 0;
+    }
+    // Only the columns the job reads have to be numbers
+    unsigned char used[MAX_COLUMNS] = { 0 };
+    for (int v = 0; v < job->input_count; v++) {
+        used[input_columns[v]] = 1;
+    }
+    long long long_lines = 0;
+
+    double *block = malloc((size_t)BATCH_ROWS * (columns + 1) * sizeof(double));
+    double *scratch = malloc((job->scratch_size + 1) * sizeof(double));
+    double *out = malloc((size_t)BATCH_ROWS * job->output_count * sizeof(double));
+    unsigned char *bad = malloc(BATCH_ROWS);
+    int ok = block != NULL && scratch != NULL && out != NULL && bad != NULL;
+    if (!ok) {
+        printf("Error: Not enough memory.\n");
+    }
+    for (int k = 0; ok && k < job->output_count; k++) {
+        ok = fprintf(output, "%s%s", job->outputs[k], k + 1 < job->output_count ? "," : "\n") > 0;
+    }
+    int more = 1;
+    while (ok && more) {
+        int count = 0;
+        while (count < BATCH_ROWS && (more = fgets(line, sizeof(line), input) != NULL)) {
+            if (line[strspn(line, " \t\r\n")] == 0) {
+                continue; // Blank line
+            }
+            double *row = block + (size_t)count * columns;
+            char *p = line;
+            bad[count] = 0;
+            if (strchr(line, '\n') == NULL && !feof(input)) {
+                // fgets() stopped at the buffer size: unless the newline is
+                // next, skip the rest of the line and give it a nan result
+                int ch = fgetc(input);
+                if (ch != '\n' && ch != EOF) {
+                    while (ch != '\n' && ch != EOF) {
+                        ch = fgetc(input);
+                    }
+                    for (int c = 0; c < columns; c++) {
+                        row[c] = NAN;
+                    }
+                    bad[count++] = 2; // Reported apart from rows with a bad value
+                    long_lines++;
+                    continue;
+                }
+            }
+            for (int c = 0; c < columns; c++) {
+                char *end = p;
+                row[c] = 0;
+                if (used[c]) {
+                    row[c] = strtod(p, &end);
+                    while (*end == ' ' || *end == '\t') {
+                        end++;
+                    }
+                    if (end == p || (*end != ',' && *end != '\r' && *end != '\n' && *end != 0)) {
+                        bad[count] = 1;
+                    }
+                }
+                p = strchr(end, ',');
+                if (p == NULL) {
+                    for (c++; c < columns; c++) {
+                        row[c] = NAN;
+                        bad[count] |= used[c];
+                    }
+                    break;
+                }
+                p++;
+            }
+            count++;
+        }
+        if (count == 0) {
+            break;
+        }
+        job->run(job, block, columns, input_columns, count, scratch, out);
+        for (int i = 0; i < count && ok; i++) {
+            *bad_rows += bad[i] == 1;
+            for (int k = 0; ok && k < job->output_count; k++) {
+                const char *separator = k + 1 < job->output_count ? "," : "\n";
+                ok = (bad[i] ? fprintf(output, "nan%s", separator)
+                             : fprintf(output, "%.17g%s", out[(size_t)k * BATCH_ROWS + i], separator)) > 0;
+            }
+        }
+        *rows_done += count;
+    }
+    if (!ok && block != NULL && scratch != NULL && out != NULL && bad != NULL) {
+        printf("Error: Could not write the output file.\n");
+    }
+    if (long_lines > 0) {
+        printf("%lld lines were longer than %d characters and were skipped; their results are nan.\n", long_lines,
+               MAX_LINE_LENGTH - 2);
+    }
+    free(block);
+    free(scratch);
+    free(out);
+    free(bad);
+    return ok;
+}
+
+// Finds the column for each input of the job. Returns 0 (after saying
+// which) if one is missing.
+int findColumns(const BatchJob *job, char names[][MAX_NAME_LENGTH + 1], int columns, int *input_columns) {
+    for (int v = 0; v < job->input_count; v++) {
+        input_columns[v] = -1;
+        for (int c = 0; c < columns && input_columns[v] < 0; c++) {
+            if (strcmp(names[c], job->inputs[v]) == 0) {
+                input_columns[v] = c;
+            }
+        }
+        if (input_columns[v] < 0) {
+            printf("Error: The data file has no column named '%s'.\n", job->inputs[v]);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Splits a CSV header line into trimmed column names. Returns the number of
+// columns, or -1 if there are more than MAX_COLUMNS.
+int splitCsvHeader(char *line, char names[][MAX_NAME_LENGTH + 1]) {
+    int columns = 0;
+    for (char *field = line; field != NULL; columns++) {
+        char *comma = strchr(field, ',');
+        if (comma != NULL) {
+            *comma = 0;
+        }
+        if (columns == MAX_COLUMNS) {
+            return -1;
+        }
+        field += strspn(field, " \t\"");
+        size_t length = strcspn(field, "\"\r\n");
+        while (length > 0 && (field[length - 1] == ' ' || field[length - 1] == '\t')) {
+            length--;
+        }
+        length = length > MAX_NAME_LENGTH ? MAX_NAME_LENGTH : length;
+        memcpy(names[columns], field, length);
+        names[columns][length] = 0;
+        field = comma != NULL ? comma + 1 : NULL;
+    }
+    return columns;
+}
+
+// Prints a prompt and reads a line into `buffer`, without its newline
+void readLine(const char *prompt, char *buffer, int size) {
+    printf("%s", prompt);
+    if (fgets(buffer, size, stdin) == NULL) {
+        buffer[0] = 0;
+        return;
+    }
+    size_t length = strlen(buffer);
+    if (length > 0 && buffer[length - 1] == '\n') {
+        buffer[--length] = 0;
+    } else {
+        clearInputBuffer();
+    }
+    if (length > 0 && buffer[length - 1] == '\r') {
+        buffer[length - 1] = 0;
+    }
+}
+
+// Compares three ways of evaluating expressions over BENCH_ROWS rows of
+// three columns held in memory: the bytecode run one row at a time (a
+// dispatch per instruction per row, like a switch over each operator), the
+// bytecode run a block at a time, and the specialized kernel where the
+// expression has one. Results must agree; returns 1 if any do not.
+int runBenchmark() {
+    static const char *expressions[] = { "3 * x + 1", "x * y + z", "2 - x * y", "(x + y) / z", "(x - 1) / y",
+                                         "x / y", "sqrt(x^2 + y^2) / z" };
+    static const char *names[] = { "x", "y", "z" };
+    int var_columns[MAX_VARIABLES];
+    double *rows = malloc((size_t)BENCH_ROWS * 3 * sizeof(double));
+    double *expected = malloc((size_t)BENCH_ROWS * sizeof(double));
+    double *out = malloc((size_t)BENCH_ROWS * sizeof(double));
+    double *stack = malloc((size_t)MAX_CODE * BATCH_ROWS * sizeof(double));
+    if (rows == NULL || expected == NULL || out == NULL || stack == NULL) {
+        printf("Error: Not enough memory.\n");
+        free(rows);
+        free(expected);
+        free(out);
+        free(stack);
+        return 1;
+    }
+    unsigned long long seed = 88172645463325252ull;
+    for (size_t i = 0; i < (size_t)BENCH_ROWS * 3; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        rows[i] = (double)(seed >> 11) / 9007199254740992.0 * 10.0 + 0.1; // In [0.1, 10.1)
+    }
+
+    printf("%d rows, best of %d passes, M rows/s:\n", BENCH_ROWS, BENCH_PASSES);
+    printf("%-22s %10s %10s %12s  %s\n", "Expression", "Per row", "Bytecode", "Specialized", "Kernel");
+    int failures = 0;
+    for (size_t e = 0; e < sizeof(expressions) / sizeof(expressions[0]); e++) {
+        Program program;
+        compileExpression(expressions[e], &program);
+        for (int v = 0; v < program.variable_count; v++) {
+            for (int c = 0; c < 3; c++) {
+                if (strcmp(program.variables[v], names[c]) == 0) {
+                    var_columns[v] = c;
+                }
+            }
+        }
+
+        double best[3] = { 1e30, 1e30, 1e30 };
+        int ways = program.kernel >= 0 ? 3 : 2;
+        for (int pass = 0; pass < BENCH_PASSES; pass++) {
+            for (int way = 0; way < ways; way++) {
+                double *target = way == 0 ? expected : out;
+                double start = nowSeconds();
+                if (way == 0) {
+                    for (int i = 0; i < BENCH_ROWS; i++) {
+                        double values[3];
+                        for (int v = 0; v < program.variable_count; v++) {
+                            values[v] = rows[(size_t)i * 3 + var_columns[v]];
+                        }
+                        target[i] = evaluateScalar(&program, values);
+                    }
+                } else {
+                    for (int done = 0; done < BENCH_ROWS; done += BATCH_ROWS) {
+                        int count = BENCH_ROWS - done < BATCH_ROWS ? BENCH_ROWS - done : BATCH_ROWS;
+                        if (way == 1) {
+                            interpretProgram(&program, rows + (size_t)done * 3, 3, var_columns, count, stack,
+                                             target + done);
+                        } else {
+                            runProgram(&program, rows + (size_t)done * 3, 3, var_columns, count, stack,
+                                       target + done);
+                        }
+                    }
+                }
+                double seconds = nowSeconds() - start;
+                best[way] = seconds < best[way] ? seconds : best[way];
+                // Contraction into fused multiply-adds may round differently
+                for (int i = 0; way > 0 && i < BENCH_ROWS; i++) {
+                    failures += fabs(out[i] - expected[i]) > 1e-12 * fabs(expected[i]);
+                }
+            }
+        }
+        char specialized[16] = "-";
+        if (ways == 3) {
+            snprintf(specialized, sizeof(specialized), "%.1f", BENCH_ROWS / best[2] / 1e6);
+        }
+        printf("%-22s %10.1f %10.1f %12s  %s\n", expressions[e], BENCH_ROWS / best[0] / 1e6,
+               BENCH_ROWS / best[1] / 1e6, specialized, ways == 3 ? kernel_shapes[program.kernel].name : "none");
+    }
+    printf("%s\n", failures == 0 ? "All results agree." : "ERROR: Results differ between evaluators.");
+    free(rows);
+    free(expected);
+    free(out);
+    free(stack);
+    return failures == 0 && runQuadraticBenchmark() ? 0 : 1;
+}
+
+// Times the quadratic solvers on BENCH_ROWS random equations (about half
+// with complex roots): the textbook formula with two square roots, the
+// scalar citardauq loop and the AVX2 kernel, which must agree with the
+// scalar loop. Then shows the accuracy difference on x^2 + 1e8 x + 1,
+// whose small root the textbook formula loses to cancellation. Returns 0
+// if the kernels disagree.
+int runQuadraticBenchmark() {
+    double *columns[7];
+    int allocated = 1;
+    for (int k = 0; k < 7; k++) {
+        columns[k] = malloc((size_t)BENCH_ROWS * sizeof(double));
+        allocated = allocated && columns[k] != NULL;
+    }
+    double *expected = malloc((size_t)BENCH_ROWS * 4 * sizeof(double));
+    if (!allocated || expected == NULL) {
+        printf("Error: Not enough memory.\n");
+        for (int k = 0; k < 7; k++) {
+            free(columns[k]);
+        }
+        free(expected);
+        return 0;
+    }
+    double *a = columns[0], *b = columns[1], *c = columns[2];
+    unsigned long long seed = 2463534242ull;
+    for (int k = 0; k < 3; k++) {
+        for (int i = 0; i < BENCH_ROWS; i++) {
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            columns[k][i] = (double)(seed >> 11) / 9007199254740992.0 * 20.0 - 10.0; // In [-10, 10)
+        }
+    }
+
+    static const char *ways[3] = { "Textbook, two sqrt", "Citardauq, scalar", "Citardauq, AVX2" };
+    double best[3] = { 1e30, 1e30, 1e30 };
+    long long differences = 0;
+    int way_count = useAVX2() ? 3 : 2;
+    for (int pass = 0; pass < BENCH_PASSES; pass++) {
+        for (int way = 0; way < way_count; way++) {
+            double start = nowSeconds();
+            if (way == 0) {
+                for (int i = 0; i < BENCH_ROWS; i++) {
+                    double d = b[i] * b[i] - 4 * a[i] * c[i];
+                    if (d >= 0) {
+                        columns[3][i] = (-b[i] + sqrt(d)) / (2 * a[i]);
+                        columns[5][i] = (-b[i] - sqrt(d)) / (2 * a[i]);
+                        columns[4][i] = columns[6][i] = 0;
+                    } else {
+                        columns[3][i] = columns[5][i] = -b[i] / (2 * a[i]);
+                        columns[4][i] = sqrt(-d) / (2 * a[i]);
+                        columns[6][i] = -columns[4][i];
+                    }
+                }
+            } else if (way == 1) {
+                solveQuadraticsScalar(a, b, c, BENCH_ROWS, columns[3], columns[4], columns[5], columns[6]);
+            } else {
+                solveQuadraticsAVX2(a, b, c, BENCH_ROWS, columns[3], columns[4], columns[5], columns[6]);
+            }
+            double seconds = nowSeconds() - start;
+            best[way] = seconds < best[way] ? seconds : best[way];
+            if (way == 1) {
+                for (int k = 0; k < 4; k++) {
+                    memcpy(expected + (size_t)k * BENCH_ROWS, columns[3 + k], (size_t)BENCH_ROWS * sizeof(double));
+                }
+            } else if (way == 2) {
+                // Contraction into fused multiply-adds may round the scalar loop differently
+                for (int k = 0; k < 4; k++) {
+                    for (int i = 0; i < BENCH_ROWS; i++) {
+                        double want = expected[(size_t)k * BENCH_ROWS + i], got = columns[3 + k][i];
+                        differences += !(fabs(got - want) <= 1e-9 * fmax(fabs(want), 1.0)) && !(isnan(got) && isnan(want));
+                    }
+                }
+            }
+        }
+    }
+
+    printf("\n%d quadratic equations, best of %d passes:\n", BENCH_ROWS, BENCH_PASSES);
+    for (int way = 0; way < way_count; way++) {
+        printf("  %-22s %8.1f M equations/s  %.1fx\n", ways[way], BENCH_ROWS / best[way] / 1e6, best[0] / best[way]);
+    }
+    if (way_count < 3) {
+        printf("  (This CPU has no AVX2.)\n");
+    }
+
+    double ill_a = 1, ill_b = 1e8, ill_c = 1, root1, root1_im, root2, root2_im;
+    solveQuadraticsScalar(&ill_a, &ill_b, &ill_c, 1, &root1, &root1_im, &root2, &root2_im);
+    double textbook = (-ill_b + sqrt(ill_b * ill_b - 4 * ill_a * ill_c)) / (2 * ill_a);
+    printf("x^2 + 1e8 x + 1: small root %.17g by the textbook formula, %.17g by citardauq (exact: about -1.00000000000000e-08).\n",
+           textbook, root2);
+    printf("%s\n", differences == 0 ? "The AVX2 and scalar results agree." : "ERROR: The AVX2 and scalar results differ.");
+    for (int k = 0; k < 7; k++) {
+        free(columns[k]);
+    }
+    free(expected);
+    return differences == 0;
+}
+
+// Monotonic wall-clock time in seconds, for throughput measurements
+double nowSeconds() {
+#ifdef _WIN32
+    LARGE_INTEGER now, freq;
+    QueryPerformanceCounter(&now);
+    QueryPerformanceFrequency(&freq);
+    return (double)now.QuadPart / (double)freq.QuadPart;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+#endif
+}
+
 // Utility function to clear the input buffer
 void clearInputBuffer() {
     int c;